@@ -0,0 +1,221 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+#include <Ilargia/Component/ComponentStorage.hpp>
+
+/*
+* Compare ComponentStorage (sparse set) with the map-based storage it
+* replaced: a buffer of elements, and an unordered_map from index to
+* position in that buffer. Both are filled, read at random indices,
+* iterated, then half of their elements are removed in random order.
+*
+* Usage: IlargiaBenchmark_ComponentStorage [elementCount] [iterations]
+*/
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Element
+	{
+		m::f32 position[3];
+		m::f32 velocity[3];
+		m::u32 flags;
+		m::u32 padding;
+	};
+
+	/*
+	* Map-based storage, as before the sparse set. The previous version
+	* mapped an index to a pointer, left dangling when the buffer grew:
+	* positions are mapped here instead, so results can be compared.
+	*/
+	class MapStorage
+	{
+	public:
+		m::i32 add(const Element& e)
+		{
+			const m::i32 id = m_nextId++;
+			m_index[id] = (m::i32)m_buffer.size();
+			m_buffer.push_back(e);
+			m_ids.push_back(id);
+			return id;
+		}
+
+		bool remove(m::i32 id)
+		{
+			auto it = m_index.find(id);
+			if (it == m_index.end())
+			{
+				return false;
+			}
+			const m::i32 pos = it->second;
+			const m::i32 last = (m::i32)m_buffer.size() - 1;
+			m_index.erase(it);
+			if (pos != last)
+			{
+				m_buffer[pos] = m_buffer[last];
+				m_ids[pos] = m_ids[last];
+				m_index[m_ids[pos]] = pos;
+			}
+			m_buffer.pop_back();
+			m_ids.pop_back();
+			return true;
+		}
+
+		MUON_INLINE Element& get(m::i32 id)
+		{
+			return m_buffer[m_index.at(id)];
+		}
+
+		//! Elements were only reachable through their index
+		template<typename Func>
+		void forEach(const Func& func)
+		{
+			for (auto it = m_index.begin(); it != m_index.end(); ++it)
+			{
+				func(m_buffer[it->second]);
+			}
+		}
+
+	private:
+		std::vector<Element> m_buffer;
+		std::vector<m::i32> m_ids;
+		std::unordered_map<m::i32, m::i32> m_index;
+		m::i32 m_nextId = 0;
+	};
+
+	typedef ilg::ComponentStorage<Element, 1024> SparseStorage;
+
+	struct Timings
+	{
+		m::f64 add;
+		m::f64 get;
+		m::f64 iterate;
+		m::f64 remove;
+		m::f32 checksum;
+	};
+
+	m::f64 elapsed(const Clock::time_point& start)
+	{
+		return std::chrono::duration<m::f64, std::milli>(Clock::now() - start).count();
+	}
+
+	Element makeElement(m::u32 i)
+	{
+		Element e = { { (m::f32)i, 0.f, 0.f }, { 1.f, 2.f, 3.f }, i, 0 };
+		return e;
+	}
+
+	template<typename Storage, typename Iterate>
+	void run(Storage& storage, const std::vector<m::u32>& order, const Iterate& iterate, Timings& t)
+	{
+		const m::u32 count = (m::u32)order.size();
+		std::vector<m::i32> ids(count);
+
+		Clock::time_point start = Clock::now();
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			ids[i] = storage.add(makeElement(i));
+		}
+		t.add += elapsed(start);
+
+		m::f32 sum = 0.f;
+		start = Clock::now();
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			sum += storage.get(ids[order[i]]).position[0];
+		}
+		t.get += elapsed(start);
+
+		start = Clock::now();
+		iterate(storage, sum);
+		t.iterate += elapsed(start);
+
+		start = Clock::now();
+		for (m::u32 i = 0; i < count / 2; ++i)
+		{
+			storage.remove(ids[order[i]]);
+		}
+		t.remove += elapsed(start);
+		t.checksum += sum;
+	}
+
+	void print(const char* name, const Timings& t, m::u32 iterations)
+	{
+		printf("%-12s add %8.3f ms  get %8.3f ms  iterate %8.3f ms  remove %8.3f ms  (checksum %g)\n"
+			   , name, t.add / iterations, t.get / iterations, t.iterate / iterations, t.remove / iterations, t.checksum);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const m::u32 count = (argc > 1 ? (m::u32)atoi(argv[1]) : 1000000);
+	const m::u32 iterations = (argc > 2 ? (m::u32)atoi(argv[2]) : 5);
+
+	// Random access order, the same for both storages
+	srand(42);
+	std::vector<m::u32> order(count);
+	for (m::u32 i = 0; i < count; ++i)
+	{
+		order[i] = i;
+	}
+	for (m::u32 i = count - 1; i > 0; --i)
+	{
+		std::swap(order[i], order[(m::u32)rand() % (i + 1)]);
+	}
+
+	printf("%u elements of %u bytes, %u iterations\n", count, (m::u32)sizeof(Element), iterations);
+	Timings map = {};
+	Timings sparse = {};
+	for (m::u32 it = 0; it < iterations; ++it)
+	{
+		MapStorage* m = new MapStorage();
+		run(*m, order, [](MapStorage& s, m::f32& sum)
+		{
+			s.forEach([&sum](Element& e) { sum += e.velocity[1]; });
+		}, map);
+		delete m;
+
+		SparseStorage* s = new SparseStorage();
+		run(*s, order, [](SparseStorage& s, m::f32& sum)
+		{
+			for (m::i32 i = 0; i < s.size(); ++i)
+			{
+				sum += s.getDense(i).velocity[1];
+			}
+		}, sparse);
+		delete s;
+	}
+	print("Map", map, iterations);
+	print("Sparse set", sparse, iterations);
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <Ilargia/Component/ComponentStorage.hpp>
+#include <Ilargia/System/JobSystem.hpp>
+#include <Ilargia/System/ParallelFor.hpp>
+
+/*
+* Scaling of parallelForEach() and parallelReduceEach() on a component
+* storage, from 1 to maxThreads threads (the main one plus workers).
+* Each pass integrates the position of every element, then sums them:
+* the sum must be the same for every thread count.
+*
+* Usage: IlargiaBenchmark_ParallelFor [elementCount] [maxThreads] [iterations] [grainSize]
+*/
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Body
+	{
+		m::f32 position[3];
+		m::f32 velocity[3];
+		m::f32 mass;
+		m::u32 flags;
+	};
+
+	typedef ilg::ComponentStorage<Body, 1024, ilg::STORAGE_GROWTH_PAGED> BodyStorage;
+
+	struct Timings
+	{
+		m::f64 forEach;
+		m::f64 reduce;
+		m::f64 checksum;
+	};
+
+	m::f64 elapsed(const Clock::time_point& start)
+	{
+		return std::chrono::duration<m::f64, std::milli>(Clock::now() - start).count();
+	}
+
+	Timings run(BodyStorage& storage, m::u32 threads, m::u32 iterations, m::i32 grainSize)
+	{
+		ilg::system::JobSystem& jobs = ilg::system::JobSystem::getInstance();
+		jobs.init(threads - 1);
+
+		Timings t = {};
+		for (m::u32 it = 0; it < iterations; ++it)
+		{
+			Clock::time_point start = Clock::now();
+			ilg::system::parallelForEach(storage, grainSize, [](Body& b)
+			{
+				const m::f32 dt = 1.f / 60.f;
+				b.position[0] += b.velocity[0] * dt;
+				b.position[1] += b.velocity[1] * dt;
+				b.position[2] += b.velocity[2] * dt;
+			});
+			t.forEach += elapsed(start);
+
+			start = Clock::now();
+			const m::f64 sum = ilg::system::parallelReduceEach(storage, grainSize, 0.0, [](m::f64& partial, const Body& b)
+			{
+				partial += (m::f64)(b.position[0] + b.position[1] + b.position[2]) * b.mass;
+			}, [](m::f64 l, m::f64 r)
+			{
+				return l + r;
+			});
+			t.reduce += elapsed(start);
+			t.checksum += sum;
+		}
+
+		jobs.term();
+		t.forEach /= iterations;
+		t.reduce /= iterations;
+		return t;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const m::u32 count = (argc > 1 ? (m::u32)atoi(argv[1]) : 1000000);
+	const m::u32 maxThreads = (argc > 2 ? (m::u32)atoi(argv[2]) : 16);
+	const m::u32 iterations = (argc > 3 ? (m::u32)atoi(argv[3]) : 20);
+	const m::i32 grainSize = (argc > 4 ? atoi(argv[4]) : 16 * 1024);
+
+	printf("%u elements of %u bytes, %u iterations, grain %d, %u hardware threads\n"
+		   , count, (m::u32)sizeof(Body), iterations, grainSize, std::thread::hardware_concurrency());
+	printf("%8s %14s %8s %14s %8s\n", "Threads", "forEach (ms)", "Speedup", "reduce (ms)", "Speedup");
+
+	m::f64 baseForEach = 0.0;
+	m::f64 baseReduce = 0.0;
+	m::f64 baseChecksum = 0.0;
+	for (m::u32 threads = 1; threads <= maxThreads; ++threads)
+	{
+		// A fresh storage per thread count, so every run integrates the same positions
+		BodyStorage* storage = new BodyStorage();
+		storage->reserve((m::i32)count);
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			Body b = { { (m::f32)(i % 1000), 0.f, 0.f }, { 1.f, 2.f, 3.f }, 1.f + (m::f32)(i % 7), 0 };
+			storage->add(b);
+		}
+
+		const Timings t = run(*storage, threads, iterations, grainSize);
+		delete storage;
+
+		if (threads == 1)
+		{
+			baseForEach = t.forEach;
+			baseReduce = t.reduce;
+			baseChecksum = t.checksum;
+		}
+		printf("%8u %14.3f %7.2fx %14.3f %7.2fx%s\n"
+			   , threads, t.forEach, baseForEach / t.forEach, t.reduce, baseReduce / t.reduce
+			   , (t.checksum == baseChecksum ? "" : "  (checksum differs!)"));
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <Ilargia/Type/TransformBatch.hpp>
+
+/*
+* Compare the world matrix composition of the Matrix functions
+* (translate, rotate then scale) with composeTransforms() at each
+* SimdLevel. Transforms form random hierarchies: each one has a parent
+* among the previous ones, or none.
+*
+* Usage: IlargiaBenchmark_TransformBatch [transformCount] [iterations]
+*/
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Input
+	{
+		std::vector<ilg::Vector> positions;
+		std::vector<ilg::Quaternion> rotations;
+		std::vector<ilg::Vector> scales;
+		std::vector<m::i32> parents;
+	};
+
+	m::f32 randomFloat(m::f32 min, m::f32 max)
+	{
+		return min + (max - min) * ((m::f32)rand() / RAND_MAX);
+	}
+
+	void generate(Input& in, m::u32 count)
+	{
+		srand(42);
+		in.positions.resize(count);
+		in.rotations.resize(count);
+		in.scales.resize(count);
+		in.parents.resize(count);
+		std::vector<m::u32> depths(count, 0);
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			in.positions[i] = ilg::Vector(randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f), randomFloat(-10.f, 10.f));
+			in.rotations[i] = ilg::Quaternion(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f)).normalize();
+			in.scales[i] = ilg::Vector(randomFloat(0.5f, 2.f), randomFloat(0.5f, 2.f), randomFloat(0.5f, 2.f));
+			// Shallow hierarchies (at most 8 levels), as in a scene
+			const m::i32 parent = (i > 0 && rand() % 4 != 0 ? (m::i32)(i - 1 - rand() % (i < 16 ? i : 16)) : -1);
+			in.parents[i] = (parent >= 0 && depths[parent] < 7 ? parent : -1);
+			depths[i] = (in.parents[i] >= 0 ? depths[parent] + 1 : 0);
+		}
+	}
+
+	m::f64 runMatrix(const Input& in, std::vector<ilg::Matrix>& out, m::u32 iterations)
+	{
+		const Clock::time_point start = Clock::now();
+		for (m::u32 it = 0; it < iterations; ++it)
+		{
+			for (size_t i = 0; i < out.size(); ++i)
+			{
+				ilg::Matrix m = (in.parents[i] >= 0 ? out[in.parents[i]] : ilg::Matrix::Identity);
+				m.translate(in.positions[i]);
+				m.rotate(in.rotations[i]);
+				m.scale(in.scales[i]);
+				out[i] = m;
+			}
+		}
+		return std::chrono::duration<m::f64, std::milli>(Clock::now() - start).count() / iterations;
+	}
+
+	m::f64 runBatch(const Input& in, std::vector<ilg::AffineMatrix>& out, m::u32 iterations)
+	{
+		ilg::TransformBatch* batch = new ilg::TransformBatch();
+		const Clock::time_point start = Clock::now();
+		for (m::u32 it = 0; it < iterations; ++it)
+		{
+			for (size_t i = 0; i < out.size(); ++i)
+			{
+				const ilg::AffineMatrix* parent = (in.parents[i] >= 0 ? &out[in.parents[i]] : &ilg::AffineMatrix::Identity);
+				batch->push(in.positions[i], in.rotations[i], in.scales[i], parent, &out[i]);
+				if (batch->isFull())
+				{
+					ilg::composeTransforms(*batch);
+				}
+			}
+			if (batch->count > 0)
+			{
+				ilg::composeTransforms(*batch);
+			}
+		}
+		const m::f64 ms = std::chrono::duration<m::f64, std::milli>(Clock::now() - start).count() / iterations;
+		delete batch;
+		return ms;
+	}
+
+	m::f32 maxError(const std::vector<ilg::Matrix>& a, const std::vector<ilg::AffineMatrix>& affine)
+	{
+		m::f32 error = 0.f;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			const ilg::Matrix b = affine[i].toMatrix();
+			for (m::i32 r = 0; r < 4; ++r)
+			{
+				for (m::i32 c = 0; c < 4; ++c)
+				{
+					const m::f32 d = std::fabs(a[i][r][c] - b[r][c]) / (1.f + std::fabs(a[i][r][c]));
+					error = (d > error ? d : error);
+				}
+			}
+		}
+		return error;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const m::u32 count = (argc > 1 ? (m::u32)atoi(argv[1]) : 500000);
+	const m::u32 iterations = (argc > 2 ? (m::u32)atoi(argv[2]) : 20);
+	static const char* levelNames[] = { "Scalar", "SSE", "AVX2" };
+
+	Input in;
+	generate(in, count);
+	std::vector<ilg::Matrix> reference(count);
+	std::vector<ilg::AffineMatrix> out(count);
+
+	printf("%u transforms, %u iterations, best SIMD level: %s\n", count, iterations, levelNames[ilg::getSupportedSimdLevel()]);
+	const m::f64 matrixMs = runMatrix(in, reference, iterations);
+	printf("%-24s %8.3f ms\n", "Matrix translate/rotate/scale", matrixMs);
+	for (m::i32 level = ilg::SIMD_SCALAR; level <= ilg::getSupportedSimdLevel(); ++level)
+	{
+		ilg::setSimdLevel((ilg::SimdLevel)level);
+		const m::f64 ms = runBatch(in, out, iterations);
+		printf("%-24s %8.3f ms  x%.2f  (max relative error %g)\n", levelNames[level], ms, matrixMs / ms, maxError(reference, out));
+	}
+	return 0;
+}
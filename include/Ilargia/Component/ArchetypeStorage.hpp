@@ -0,0 +1,234 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_ARCHETYPESTORAGE_HPP
+#define INCLUDE_ILARGIA_ARCHETYPESTORAGE_HPP
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/Meta/MetaDatabase.hpp>
+#include "Ilargia/Component/ComponentStorage.hpp"
+#include "Ilargia/Component/Entity.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief Describe how a Component type is stored in an Archetype column
+	* Function pointers are used so the Archetype can move and destroy
+	* elements without knowing their type.
+	*/
+	struct ArchetypeColumn
+	{
+		m::u64 type;
+		m::u32 size;
+		m::u32 alignment;
+		void(*construct)(void* dst);
+		void(*relocate)(void* dst, void* src); //!< Move src into dst, then destroy src
+		void(*destroy)(void* ptr);
+
+		template<typename T>
+		static const ArchetypeColumn& get()
+		{
+			struct Impl
+			{
+				static void construct(void* dst) { new (dst) T(); }
+				static void relocate(void* dst, void* src) { detail::Relocator<T>::relocate((T*)dst, (T*)src); }
+				static void destroy(void* ptr) { ((T*)ptr)->~T(); }
+			};
+			static const ArchetypeColumn column = { MUON_TRAITS_ID(T), sizeof(T), alignof(T), &Impl::construct, &Impl::relocate, &Impl::destroy };
+			return column;
+		}
+	};
+
+	//! A fixed-size memory block holding the columns of up to Archetype::getChunkCapacity() entities
+	struct ArchetypeChunk
+	{
+		m::u8* buffer;
+		m::u32 count;
+	};
+
+	/*!
+	* @brief Every Entity having exactly the same set of Component
+	* Entities are stored in ArchetypeStorage::CHUNK_SIZE chunks, with one
+	* column per Component type (Structure of Arrays): iterating over a
+	* Component of every Entity of the archetype is a linear read.
+	* Only the last chunk can be partially filled.
+	*/
+	class ILARGIA_API Archetype : public m::helper::NonCopyable
+	{
+		friend class ArchetypeStorage;
+		Archetype(const std::vector<ArchetypeColumn>& columns);
+	public:
+		~Archetype();
+
+		//! Return the column index of a Component type, or m::INVALID_INDEX
+		m::i32 getColumnIndex(m::u64 type) const;
+		bool hasType(m::u64 type) const;
+
+		const std::vector<ArchetypeColumn>& getColumns() const;
+		m::u32 getChunkCapacity() const;
+		m::u32 getChunkCount() const;
+		m::u32 getEntityCount() const;
+		const ArchetypeChunk& getChunk(m::u32 chunk) const;
+
+		MUON_INLINE EntityId* getEntities(const ArchetypeChunk& chunk) const
+		{
+			return (EntityId*)chunk.buffer;
+		}
+
+		MUON_INLINE void* getColumn(const ArchetypeChunk& chunk, m::i32 column) const
+		{
+			return chunk.buffer + (*m_offsets)[column];
+		}
+
+		template<typename T>
+		MUON_INLINE T* getColumn(const ArchetypeChunk& chunk) const
+		{
+			return (T*)getColumn(chunk, getColumnIndex(MUON_TRAITS_ID(T)));
+		}
+
+	private:
+		void* _getElement(m::u32 row, m::i32 column) const;
+		m::u32 _allocRow(EntityId id);
+		EntityId _removeRow(m::u32 row, bool destroy);
+
+		typedef std::vector<ArchetypeColumn> ColumnList;
+		typedef std::vector<m::u32> OffsetList;
+		typedef std::vector<ArchetypeChunk> ChunkList;
+		typedef std::unordered_map<m::u64, Archetype*> EdgeMap;
+
+		ColumnList* m_columns;
+		OffsetList* m_offsets;
+		ChunkList* m_chunks;
+		EdgeMap* m_addEdges;
+		EdgeMap* m_removeEdges;
+		m::u32 m_chunkCapacity;
+		m::u32 m_entityCount;
+	};
+
+	/*!
+	* @brief Store components grouped by Archetype
+	* This is an alternative to the per-type storage of component managers:
+	* entities registered here get their components stored in chunks shared
+	* with every Entity having the same component set, so a system working
+	* on several Component types streams all their columns linearly.
+	* The EntityManager owns one, used by every manager declared with
+	* ILARGIA_COMPONENT_MANAGER_DECL_ARCHETYPE (see IArchetypeManager):
+	* destroying an Entity unregisters it from that storage.
+	* Other instances are standalone, their entities must be removed by hand.
+	*/
+	class ILARGIA_API ArchetypeStorage : public m::helper::NonCopyable
+	{
+	public:
+		static const m::u32 CHUNK_SIZE = 16 * 1024;
+
+		ArchetypeStorage();
+		~ArchetypeStorage();
+
+		//! Register an Entity without any Component
+		void addEntity(EntityId id);
+		//! Destroy every Component of the Entity, and unregister it
+		bool removeEntity(EntityId id);
+		bool hasEntity(EntityId id) const;
+
+		template<typename T>
+		T* addComponent(EntityId id)
+		{
+			return (T*)_addComponent(id, ArchetypeColumn::get<T>());
+		}
+
+		template<typename T>
+		bool removeComponent(EntityId id)
+		{
+			return _removeComponent(id, MUON_TRAITS_ID(T));
+		}
+
+		template<typename T>
+		T* getComponent(EntityId id) const
+		{
+			return (T*)_getComponent(id, MUON_TRAITS_ID(T));
+		}
+
+		m::u32 getArchetypeCount() const;
+		Archetype* getArchetype(m::u32 index) const;
+
+		/*!
+		* @brief Call a function on every chunk containing all the given types
+		* The function receives the number of entities in the chunk, their ids,
+		* and one pointer per requested column:
+		* storage.forEach<Transform, Velocity>([](m::u32 count, EntityId* ids, Transform* t, Velocity* v) { ... });
+		*/
+		template<typename ...Types, typename Func>
+		void forEach(Func func) const
+		{
+			const m::u64 types[] = { MUON_TRAITS_ID(Types)..., 0 };
+			for (auto it = m_archetypeList->begin(); it != m_archetypeList->end(); ++it)
+			{
+				Archetype* archetype = *it;
+				if (archetype->getEntityCount() == 0 || !_matchTypes(archetype, types, sizeof...(Types)))
+				{
+					continue;
+				}
+				for (m::u32 c = 0; c < archetype->getChunkCount(); ++c)
+				{
+					const ArchetypeChunk& chunk = archetype->getChunk(c);
+					func(chunk.count, archetype->getEntities(chunk), archetype->getColumn<Types>(chunk)...);
+				}
+			}
+		}
+
+	private:
+		struct EntityLocation
+		{
+			EntityId id;
+			Archetype* archetype;
+			m::u32 row;
+		};
+
+		void* _addComponent(EntityId id, const ArchetypeColumn& column);
+		bool _removeComponent(EntityId id, m::u64 type);
+		void* _getComponent(EntityId id, m::u64 type) const;
+		bool _matchTypes(const Archetype* archetype, const m::u64* types, m::u32 count) const;
+
+		EntityLocation* _getLocation(EntityId id) const;
+		Archetype* _getArchetype(const std::vector<ArchetypeColumn>& columns);
+		void _moveEntity(EntityLocation& location, Archetype* target);
+
+		typedef std::map<std::vector<m::u64>, Archetype*> ArchetypeMap;
+		typedef std::vector<Archetype*> ArchetypeList;
+		typedef std::vector<EntityLocation> LocationList;
+
+		ArchetypeMap* m_archetypes;
+		ArchetypeList* m_archetypeList;
+		LocationList* m_locations;
+		Archetype* m_emptyArchetype;
+	};
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_COMMANDBUFFER_HPP
+#define INCLUDE_ILARGIA_COMMANDBUFFER_HPP
+
+#include <vector>
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/Helper/Singleton.hpp>
+#include "Ilargia/Component/EntityId.hpp"
+#include "Ilargia/Manager/ComponentTypeIndex.hpp"
+
+namespace ilg
+{
+	class CommandQueue;
+
+	//! An Entity created by a CommandBuffer, only valid in commands of the same buffer
+	struct PendingEntity
+	{
+		m::u32 index;
+	};
+
+	/*!
+	* @brief Record structural changes to apply them later
+	* Creating or destroying an Entity, adding or removing a Component and
+	* changing a parent modify storages and notify managers immediately,
+	* which is not safe while managers are updated in parallel. Commands
+	* recorded here are only applied by playback(), on the main thread.
+	*
+	* Commands are not applied in the order they were recorded but in
+	* batches, one kind after the other:
+	* - every Entity is created
+	* - parents are changed, in recording order
+	* - components are added and removed, sorted by type then by Entity:
+	* the commands on the Component of a given Entity keep their recording
+	* order, so the last one wins
+	* - entities are destroyed
+	* Commands targeting an Entity destroyed in the meantime are ignored.
+	*/
+	class ILARGIA_API CommandBuffer : public m::helper::NonCopyable
+	{
+		friend class CommandQueue;
+	public:
+		//! Target of a command: an existing Entity, or one created by this buffer
+		struct Target
+		{
+			Target(EntityId id)
+				: value(id)
+				, pending(false)
+			{
+			}
+
+			Target(PendingEntity entity)
+				: value(entity.index)
+				, pending(true)
+			{
+			}
+
+			m::u32 value;
+			bool pending;
+		};
+
+		CommandBuffer();
+		~CommandBuffer();
+
+		PendingEntity create();
+		void destroy(const Target& entity);
+
+		//! Set the parent of an Entity, or detach it if parent is INVALID_ENTITY
+		void setParent(const Target& entity, const Target& parent);
+
+		template<typename T>
+		void addComponent(const Target& entity)
+		{
+			_record(COMMAND_ADD_COMPONENT, entity, manager::getComponentTypeIndex<T>(), false);
+		}
+
+		template<typename T>
+		void removeComponent(const Target& entity)
+		{
+			_record(COMMAND_REMOVE_COMPONENT, entity, manager::getComponentTypeIndex<T>(), false);
+		}
+
+		//! Number of recorded commands, creations included
+		m::u32 size() const;
+		bool empty() const;
+
+		//! Drop every recorded command
+		void clear();
+
+		//! Apply every recorded command, then clear the buffer
+		void playback();
+
+	private:
+		enum CommandType
+		{
+			COMMAND_DESTROY = 0,
+			COMMAND_SET_PARENT,
+			COMMAND_ADD_COMPONENT,
+			COMMAND_REMOVE_COMPONENT,
+		};
+
+		enum CommandFlag
+		{
+			COMMAND_PENDING_ENTITY = 1 << 0,
+			COMMAND_PENDING_ARG = 1 << 1,
+		};
+
+		struct Command
+		{
+			m::u16 type;
+			m::u16 flags;
+			m::u32 entity;
+			m::u32 arg;
+		};
+
+		void _record(CommandType type, const Target& entity, m::u32 arg, bool pendingArg);
+		EntityId _resolve(m::u32 value, bool pending) const;
+
+		static void _playback(CommandBuffer* const* buffers, m::u32 count);
+
+		std::vector<Command>* m_commands;
+		std::vector<EntityId>* m_created;
+		m::u32 m_createCount;
+	};
+
+	/*!
+	* @brief One CommandBuffer per JobSystem thread
+	* A thread can record commands in its own buffer without any lock.
+	* Every buffer is played back by flush(), called by the Engine once
+	* every manager has been updated.
+	*/
+	class ILARGIA_API CommandQueue : public m::helper::NonCopyable
+	{
+	public:
+		MUON_SINGLETON_GET(CommandQueue);
+
+		//! Create one buffer per thread, see JobSystem::getThreadIndex()
+		void init(m::u32 threadCount);
+
+		//! Return the buffer of the calling thread
+		CommandBuffer& getBuffer();
+
+		//! Apply the commands of every buffer, then clear them
+		void flush();
+
+	private:
+		CommandQueue();
+		~CommandQueue();
+
+		void _release();
+
+		std::vector<CommandBuffer*>* m_buffers;
+	};
+}
+
+#endif
@@ -32,6 +32,7 @@
 #include <Muon/Meta/MetaDatabase.hpp>
 #include <Muon/String.hpp>
 #include "Ilargia/Core/Define.hpp"
+#include "Ilargia/Manager/ComponentTypeIndex.hpp"
 
 namespace ilg
 {
@@ -40,25 +41,29 @@ namespace ilg
 		class IBaseManager;
 	}
 	class Entity;
+	/*!
+	* @brief Handle on a component instance
+	* A Component is a small trivially copyable value: the dense type index
+	* of its manager (see ManagerFactory), the instance index in the storage
+	* of the manager, and the generation of that index when the handle was
+	* created. Type id and name are resolved on demand from the type table.
+	*/
 	class ILARGIA_API Component
 	{
 	public:
 		Component();
-		Component(const Component& c);
-		Component& operator=(const Component& c);
 
 		m::i32 getInstanceIndex() const;
+		m::u32 getInstanceGeneration() const;
+		m::u32 getTypeIndex() const;
 		m::u64 getInstanceTypeId() const;
 		m::String getInstanceName() const;
 
+		//! Type names are only looked up by the assertions, from the dense type index
 		template<typename T>
 		MUON_INLINE T* cast() const
 		{
-			if (T* ptr = (T*)_cast(MUON_META(T)->id(), MUON_META(T)->name()))
-			{
-				return ptr;
-			}
-			return NULL;
+			return (T*)_cast(manager::getComponentTypeIndex<T>());
 		}
 
 		template<typename T>
@@ -71,13 +76,13 @@ namespace ilg
 		friend class manager::IBaseManager;
 		friend class Entity;
 
-		Component(m::u64, m::i32, const m::String&);
-		void* _cast(m::u64, const char*) const;
+		Component(m::u32, m::i32, m::u32);
+		void* _cast(m::u32) const;
 
 	protected:
-		m::u64 m_instanceTypeId;
+		m::u32 m_typeIndex;
 		m::i32 m_instanceIndex;
-		m::String m_instanceName;
+		m::u32 m_instanceGeneration;
 	};
 }
 MUON_TRAITS_DECL(ilg::Component);
@@ -0,0 +1,176 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_COMPONENTMASK_HPP
+#define INCLUDE_ILARGIA_COMPONENTMASK_HPP
+
+#include <Muon/System/Assert.hpp>
+#include "Ilargia/Core/Define.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief Fixed-width set of component type indices
+	* Bit N is set when the component type of dense index N (see
+	* ManagerFactory) is present. The width is ILARGIA_MAX_COMPONENT_TYPES,
+	* chosen at build time, so a mask is a plain array of words: testing a
+	* type is a single bit test, and matching a query is one AND per word.
+	*/
+	class ComponentMask
+	{
+		static_assert(ILARGIA_MAX_COMPONENT_TYPES > 0 && ILARGIA_MAX_COMPONENT_TYPES % 64 == 0
+					  , "ILARGIA_MAX_COMPONENT_TYPES must be a multiple of 64!");
+		static_assert(ILARGIA_MAX_COMPONENT_TYPES <= 256
+					  , "ILARGIA_MAX_COMPONENT_TYPES can't be greater than 256!");
+	public:
+		static const m::u32 WORD_COUNT = ILARGIA_MAX_COMPONENT_TYPES / 64;
+
+		ComponentMask()
+		{
+			clear();
+		}
+
+		MUON_INLINE void set(m::u32 typeIndex)
+		{
+			MUON_ASSERT(typeIndex < ILARGIA_MAX_COMPONENT_TYPES, "Type index out of range! (%u)", typeIndex);
+			m_words[typeIndex >> 6] |= (m::u64)1 << (typeIndex & 63);
+		}
+
+		MUON_INLINE void reset(m::u32 typeIndex)
+		{
+			MUON_ASSERT(typeIndex < ILARGIA_MAX_COMPONENT_TYPES, "Type index out of range! (%u)", typeIndex);
+			m_words[typeIndex >> 6] &= ~((m::u64)1 << (typeIndex & 63));
+		}
+
+		//! Return false for any out of range index (such as INVALID_TYPE_INDEX)
+		MUON_INLINE bool test(m::u32 typeIndex) const
+		{
+			return typeIndex < ILARGIA_MAX_COMPONENT_TYPES
+				&& (m_words[typeIndex >> 6] & ((m::u64)1 << (typeIndex & 63))) != 0;
+		}
+
+		//! Return true if every bit set in other is also set here
+		MUON_INLINE bool contains(const ComponentMask& other) const
+		{
+			for (m::u32 i = 0; i < WORD_COUNT; ++i)
+			{
+				if ((m_words[i] & other.m_words[i]) != other.m_words[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//! Return the number of types set
+		MUON_INLINE m::u32 count() const
+		{
+			m::u32 total = 0;
+			for (m::u32 i = 0; i < WORD_COUNT; ++i)
+			{
+				total += popCount(m_words[i]);
+			}
+			return total;
+		}
+
+		/*!
+		* @brief Return the number of types set below typeIndex
+		* That is the position of the type among the ones set, so values
+		* stored per type set can be packed, in type index order.
+		*/
+		MUON_INLINE m::u32 rank(m::u32 typeIndex) const
+		{
+			MUON_ASSERT(typeIndex < ILARGIA_MAX_COMPONENT_TYPES, "Type index out of range! (%u)", typeIndex);
+			const m::u32 word = typeIndex >> 6;
+			m::u32 total = 0;
+			for (m::u32 i = 0; i < word; ++i)
+			{
+				total += popCount(m_words[i]);
+			}
+			return total + popCount(m_words[word] & (((m::u64)1 << (typeIndex & 63)) - 1));
+		}
+
+		MUON_INLINE bool empty() const
+		{
+			for (m::u32 i = 0; i < WORD_COUNT; ++i)
+			{
+				if (m_words[i] != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		MUON_INLINE void clear()
+		{
+			for (m::u32 i = 0; i < WORD_COUNT; ++i)
+			{
+				m_words[i] = 0;
+			}
+		}
+
+		MUON_INLINE bool operator==(const ComponentMask& other) const
+		{
+			for (m::u32 i = 0; i < WORD_COUNT; ++i)
+			{
+				if (m_words[i] != other.m_words[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		MUON_INLINE bool operator!=(const ComponentMask& other) const
+		{
+			return !(*this == other);
+		}
+
+		MUON_INLINE m::u64 getWord(m::u32 word) const
+		{
+			return m_words[word];
+		}
+
+	private:
+		static MUON_INLINE m::u32 popCount(m::u64 word)
+		{
+#if defined(__GNUC__)
+			return (m::u32)__builtin_popcountll(word);
+#else
+			word = word - ((word >> 1) & 0x5555555555555555ull);
+			word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+			word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+			return (m::u32)((word * 0x0101010101010101ull) >> 56);
+#endif
+		}
+
+		m::u64 m_words[WORD_COUNT];
+	};
+}
+
+#endif
@@ -28,50 +28,198 @@
 #ifndef INCLUDE_ILARGIA_COMPONENTSTORAGE_HPP
 #define INCLUDE_ILARGIA_COMPONENTSTORAGE_HPP
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
-#include <unordered_map>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <Muon/Core/Constant.hpp>
 #include <Muon/System/Assert.hpp>
 #include "Ilargia/Core/Define.hpp"
+#include "Ilargia/Component/EntityId.hpp"
 
 namespace ilg
 {
+	/*!
+	* @brief How a ComponentStorage grows when reaching its memory limit
+	*/
+	enum StorageGrowth
+	{
+		STORAGE_GROWTH_FIXED = 0,	//!< One buffer, grown by ChunkSize elements (may move in memory)
+		STORAGE_GROWTH_PAGED,		//!< Pages of ChunkSize elements, never moved when growing
+		STORAGE_GROWTH_GEOMETRIC,	//!< One buffer, starting at ChunkSize elements and grown by half its capacity
+	};
+
+	/*!
+	* @brief Whether a T can be moved in memory with memcpy / realloc
+	* True for trivially copyable types. Types owning resources that don't
+	* depend on their own address (most std::vector, m::String...) can opt
+	* in with ILARGIA_TRIVIALLY_RELOCATABLE(Type), at global scope.
+	* Other types are moved with their move constructor, then destroyed.
+	*/
+	template<typename T>
+	struct IsTriviallyRelocatable
+	{
+		enum { value = std::is_trivially_copyable<T>::value };
+	};
+
+#define ILARGIA_TRIVIALLY_RELOCATABLE(Type) namespace ilg { template<> struct IsTriviallyRelocatable<Type> { enum { value = true }; }; }
+
+	/*!
+	* @brief Memory usage of a storage, see BasicComponentStorage::getStats()
+	*/
+	struct StorageStats
+	{
+		m::i32 size;			//!< Number of live elements
+		m::i32 capacity;		//!< Number of elements that fit without reallocation
+		m::i32 peakSize;		//!< Highest size ever reached
+		m::i32 freeIndices;		//!< Removed indices waiting to be recycled
+		m::u32 reallocCount;	//!< Number of times the buffers were resized
+		m::u64 bytes;			//!< Memory allocated, elements and bookkeeping arrays
+		m::u64 usedBytes;		//!< Part of bytes used by live elements
+		m::f32 fragmentation;	//!< Ratio of allocated memory not used by live elements [0..1]
+	};
+
+	namespace detail
+	{
+		template<typename T, bool Trivial = IsTriviallyRelocatable<T>::value>
+		struct Relocator
+		{
+			//! Move src into uninitialized dst, then destroy src
+			static MUON_INLINE void relocate(T* dst, T* src)
+			{
+				memcpy((void*)dst, (const void*)src, sizeof(T));
+			}
+
+			//! Resize a buffer holding count elements, NULL on failure
+			static T* reallocate(T* buffer, m::i32 /*count*/, m::i32 capacity)
+			{
+				return (T*)realloc((void*)buffer, sizeof(T) * capacity);
+			}
+		};
+
+		template<typename T>
+		struct Relocator<T, false>
+		{
+			static MUON_INLINE void relocate(T* dst, T* src)
+			{
+				new (dst) T(std::move(*src));
+				src->~T();
+			}
+
+			static T* reallocate(T* buffer, m::i32 count, m::i32 capacity)
+			{
+				T* tmp = (T*)malloc(sizeof(T) * capacity);
+				if (tmp != NULL)
+				{
+					for (m::i32 i = 0; i < count; ++i)
+					{
+						relocate(tmp + i, buffer + i);
+					}
+					free(buffer);
+				}
+				return tmp;
+			}
+		};
+	}
+
 	/*!
 	* @brief Array used for storing Component
 	* This array has a special storage system primarly
 	* designed to work for Component.
 	* It is based on an Index identifier: when adding, an index is returned.
-	* This is the location in the array where the data is stored.
-	* @template T Component you want to store
-	* @template chunk How the Array will grow when reaching its memory limit
+	* This index stays valid until the element is removed, even if other
+	* elements are added or removed in the meantime.
+	*
+	* Internally this is a sparse set: the index points in a sparse array
+	* giving the location of the element in a packed (dense) buffer.
+	* The dense buffer has no hole, and can be iterated linearly with
+	* getDense(), from 0 to size().
+	* Removed indices are recycled by the next add() call, each index has
+	* a generation incremented on removal to detect stale handles.
+	* Each element can be given the EntityId of its owner, stored in a
+	* dense array alongside the elements (see getOwners()).
+	*
+	* Writes are tracked with versions: adding an element, or accessing
+	* it with getMutable() / markChanged(), stamps it and its change chunk
+	* (CHANGE_CHUNK_SIZE dense positions) with the current version.
+	* A consumer keeps the value returned by advanceVersion() and later
+	* skips every chunk, then element, not changed since (see changedSince()).
+	*
+	* The dense buffer is split in pages, accessed through a page table:
+	* - STORAGE_GROWTH_FIXED uses a single page, reallocated when full.
+	* - STORAGE_GROWTH_GEOMETRIC uses a single page too, but grows it by
+	* half of its capacity so filling it costs amortized O(1) copies.
+	* - STORAGE_GROWTH_PAGED allocates a new page when full: elements are
+	* never moved by add() or reserve().
+	* Whatever the growth, remove() keeps the dense buffer packed by moving
+	* the last element in the hole: the address of that element changes.
+	* swapDense() moves elements too, whatever the growth.
+	* A pointer is thus only safe until the next removal or swap, keep the
+	* index (and its generation) to find an element again in a later frame.
+	* Whatever the growth, reserve() allocates room for a known count at
+	* once, and shrinkToFit() releases the memory not needed anymore.
+	*
+	* Elements are moved (on removal, or when a single buffer grows) with
+	* memcpy / realloc if IsTriviallyRelocatable, with their move
+	* constructor otherwise.
+	*
+	* The growth parameters are only known at runtime by this class, so
+	* code working on any storage of T can use it directly.
+	* See ComponentStorage for the compile-time version.
 	*/
-	template<typename T, m::i32 ChunkSize>
-	class ComponentStorage
+	template<typename T>
+	class BasicComponentStorage
 	{
 	public:
+		static const m::i32 CHANGE_CHUNK_SIZE = 64;
+
 		//----------------------
 		// Constructor
 		//----------------------
-		ComponentStorage()
-			: m_capacity(ChunkSize)
+		BasicComponentStorage(m::i32 chunkSize, StorageGrowth growth)
+			: m_chunkSize(chunkSize)
+			, m_growth(growth)
+			, m_pageShift(31)
+			, m_pageMask(0x7FFFFFFF)
+			, m_capacity(0)
 			, m_size(0)
+			, m_indexCount(0)
+			, m_pageCount(0)
+			, m_pages(NULL)
+			, m_sparse(NULL)
+			, m_dense(NULL)
+			, m_owners(NULL)
+			, m_generations(NULL)
+			, m_version(1)
+			, m_versions(NULL)
+			, m_chunkVersions(NULL)
+			, m_peakSize(0)
+			, m_reallocCount(0)
 		{
-			MUON_ASSERT_BREAK(ChunkSize > 0, "Creating 0 Chunk-size!");
-
-			m_buffer = (T*)malloc(sizeof(T) * ChunkSize);
-			MUON_ASSERT_BREAK(m_buffer != NULL
-							  , "Buffer can't be allocated (Size: %u)"
-							  , sizeof(T) * ChunkSize);
+			MUON_ASSERT_BREAK(chunkSize > 0, "Creating 0 Chunk-size!");
+			if (m_growth == STORAGE_GROWTH_PAGED)
+			{
+				MUON_ASSERT_BREAK((chunkSize & (chunkSize - 1)) == 0
+								  , "Paged storage requires a power of two Chunk-size! (Chunk: %d)"
+								  , chunkSize);
+				m_pageShift = 0;
+				while ((1 << m_pageShift) < chunkSize)
+				{
+					++m_pageShift;
+				}
+				m_pageMask = chunkSize - 1;
+			}
+			reallocBuffer();
 		}
 
 		//----------------------
 		// Constructor
 		//----------------------
-		~ComponentStorage()
+		~BasicComponentStorage()
 		{
-			free(m_buffer);
-			m_capacity = 0;
-			m_size = 0;
+			release();
 		}
 
 		//----------------------
@@ -79,27 +227,94 @@ namespace ilg
 		//----------------------
 		m::i32 add()
 		{
-			reallocBuffer();
-			m_index[m_size] = m_buffer + m_size;
-			new (m_buffer + m_size) T();
-			return m_size++;
+			m::i32 id = allocIndex();
+			new (address(m_size)) T();
+			markChangedDense(m_size);
+			++m_size;
+			return id;
 		}
 
 		m::i32 add(const T& defaultValue)
 		{
-			reallocBuffer();
-			m_index[m_size] = m_buffer + m_size;
-			new (m_buffer + m_size) T(defaultValue);
-			return m_size++;
+			m::i32 id = allocIndex();
+			new (address(m_size)) T(defaultValue);
+			markChangedDense(m_size);
+			++m_size;
+			return id;
 		}
 
 		template<typename ...Args>
 		m::i32 add(Args...args)
 		{
-			reallocBuffer();
-			m_index[m_size] = m_buffer + m_size;
-			new (m_buffer + m_size) T(std::forward<Args>(args)...);
-			return m_size++;
+			m::i32 id = allocIndex();
+			new (address(m_size)) T(std::forward<Args>(args)...);
+			markChangedDense(m_size);
+			++m_size;
+			return id;
+		}
+
+		/*!
+		* @brief Add count copies of src[0..count[ in one go
+		* Storage is reserved once, elements are copied with one memcpy per
+		* page when T is trivially copyable, and indices are filled in a
+		* single loop, recycling removed ones first as add() does.
+		* @param owners Entity owning each new element, or NULL for none
+		* @return Dense position of the first new element, the others follow
+		*/
+		m::i32 append(const T* src, m::i32 count, const EntityId* owners)
+		{
+			reserve(m_size + count);
+			const m::i32 first = m_size;
+			const m::i32 page = pageSize();
+			for (m::i32 i = 0; i < count;)
+			{
+				const m::i32 run = std::min(page - (first + i) % page, count - i);
+				T* dst = address(first + i);
+				if (std::is_trivially_copyable<T>::value)
+				{
+					memcpy((void*)dst, (const void*)(src + i), sizeof(T) * run);
+				}
+				else
+				{
+					for (m::i32 j = 0; j < run; ++j)
+					{
+						new (dst + j) T(src[i + j]);
+					}
+				}
+				i += run;
+			}
+
+			for (m::i32 pos = first; pos < first + count; ++pos)
+			{
+				m::i32 id = pos;
+				if (pos < m_indexCount)
+				{
+					id = m_dense[pos];
+				}
+				else
+				{
+					m_generations[id] = 0;
+					++m_indexCount;
+				}
+				m_dense[pos] = id;
+				m_sparse[id] = pos;
+				m_owners[pos] = (owners != NULL ? owners[pos - first] : INVALID_ENTITY);
+				m_versions[pos] = m_version;
+			}
+			if (count > 0)
+			{
+				for (m::i32 chunk = first / CHANGE_CHUNK_SIZE; chunk <= (first + count - 1) / CHANGE_CHUNK_SIZE; ++chunk)
+				{
+					m_chunkVersions[chunk] = m_version;
+				}
+			}
+
+			m_size += count;
+			if (m_size > m_peakSize)
+			{
+				m_peakSize = m_size;
+			}
+			return first;
 		}
 
 		//----------------------
@@ -107,54 +322,121 @@ namespace ilg
 		//----------------------
 		bool remove(m::i32 id)
 		{
-			auto it = m_index.find(id);
-			MUON_ASSERT(it != m_index.end(), "Index doesn't exists in Array!");
-			if (it == m_index.end())
+			MUON_ASSERT(has(id), "Index doesn't exists in Array!");
+			if (!has(id))
 			{
 				return false;
 			}
 
-			//Swap last and id, and update index map
-			//Only if there is at least two elements
-			m_buffer[id].~T();
-			m_index.erase(it);
-			if (m_size > 1 && ((m_buffer + id) != (m_buffer + m_size - 1)))
+			//Swap last and removed element, and update the sparse array
+			//of the moved one. The removed index is kept after the
+			//last dense element, so it can be recycled by add()
+			m::i32 pos = m_sparse[id];
+			m::i32 last = m_size - 1;
+			address(pos)->~T();
+			if (pos != last)
 			{
-				memcpy(m_buffer + id, m_buffer + m_size - 1, sizeof(T));
-				//Index map swap only if there is more than 2 elements
-				if (m_index.size() > 1)
+				detail::Relocator<T>::relocate(address(pos), address(last));
+				m::i32 movedId = m_dense[last];
+				m_dense[pos] = movedId;
+				m_owners[pos] = m_owners[last];
+				m_sparse[movedId] = pos;
+				// The moved element keeps its version, its new chunk must not hide it
+				m_versions[pos] = m_versions[last];
+				if (m_chunkVersions[pos / CHANGE_CHUNK_SIZE] < m_versions[pos])
 				{
-					m_index[m_size - 1] = m_buffer + id;
+					m_chunkVersions[pos / CHANGE_CHUNK_SIZE] = m_versions[pos];
 				}
 			}
+			m_dense[last] = id;
+			m_sparse[id] = m::INVALID_INDEX;
+			++m_generations[id];
 			--m_size;
 			return true;
 		}
 
-		//----------------------
-		//
-		//----------------------
+		/*!
+		* @brief Remove every element
+		* Memory is kept (see shrinkToFit()), and so are the generations:
+		* each index is removed as with remove(), so a handle taken before
+		* never matches an element added afterwards.
+		*/
 		m::i32 clear()
 		{
 			m::i32 nbElement = m_size;
-			for (auto it = m_index.begin(); it != m_index.end(); ++it)
+			for (m::i32 i = 0; i < m_size; ++i)
 			{
-				it->second->~T();
+				address(i)->~T();
+				// Live indices come first in the dense array, free ones after: all are free now
+				m::i32 id = m_dense[i];
+				m_sparse[id] = m::INVALID_INDEX;
+				++m_generations[id];
 			}
-
-			free(m_buffer);
-			m_buffer = NULL;
-			m_capacity = 0;
 			m_size = 0;
 			return nbElement;
 		}
 
+		//! Per-element memory: the element and its sparse, dense, owner, generation and version entries
+		static MUON_INLINE m::u64 elementBytes()
+		{
+			return sizeof(T) + sizeof(m::i32) * 2 + sizeof(EntityId) + sizeof(m::u32) * 2;
+		}
+
+		StorageStats getStats() const
+		{
+			StorageStats stats;
+			stats.size = m_size;
+			stats.capacity = m_capacity;
+			stats.peakSize = m_peakSize;
+			stats.freeIndices = m_indexCount - m_size;
+			stats.reallocCount = m_reallocCount;
+			stats.bytes = (m::u64)m_capacity * elementBytes()
+				+ (m::u64)((m_capacity + CHANGE_CHUNK_SIZE - 1) / CHANGE_CHUNK_SIZE) * sizeof(m::u32)
+				+ (m::u64)m_pageCount * sizeof(T*);
+			stats.usedBytes = (m::u64)m_size * elementBytes();
+			stats.fragmentation = (stats.bytes > 0 ? 1.f - (m::f32)((double)stats.usedBytes / (double)stats.bytes) : 0.f);
+			return stats;
+		}
+
+		//! Make room for at least capacity elements, without any further allocation
+		void reserve(m::i32 capacity)
+		{
+			if (capacity > m_capacity)
+			{
+				setCapacity(capacity);
+			}
+		}
+
+		/*!
+		* @brief Release unused memory
+		* Capacity is lowered to the number of indices ever given (removed
+		* indices are kept for recycling), and at least ChunkSize.
+		*/
+		void shrinkToFit()
+		{
+			m::i32 capacity = (m_indexCount > m_chunkSize ? m_indexCount : m_chunkSize);
+			if (m_growth == STORAGE_GROWTH_PAGED)
+			{
+				capacity = ((capacity + m_chunkSize - 1) / m_chunkSize) * m_chunkSize;
+			}
+			if (capacity < m_capacity)
+			{
+				setCapacity(capacity);
+			}
+		}
+
 		//----------------------
 		// Getters
 		//----------------------
+		MUON_INLINE bool has(m::i32 id) const
+		{
+			return id >= 0 && id < m_indexCount && m_sparse[id] != m::INVALID_INDEX;
+		}
+
 		MUON_INLINE T& get(m::i32 id) const
 		{
-			return *(m_index.at(id));
+			MUON_ASSERT(has(id), "Index doesn't exists in Array!");
+			return *address(m_sparse[id]);
 		}
 
 		MUON_INLINE T& operator[](m::i32 id) const
@@ -162,6 +444,198 @@ namespace ilg
 			return get(id);
 		}
 
+		//! Access the element stored at a dense position [0..size()[
+		MUON_INLINE T& getDense(m::i32 pos) const
+		{
+			return *address(pos);
+		}
+
+		//! Return the index of the element stored at a dense position
+		MUON_INLINE m::i32 getIndex(m::i32 pos) const
+		{
+			return m_dense[pos];
+		}
+
+		//! Return the dense position of an index
+		MUON_INLINE m::i32 getPosition(m::i32 id) const
+		{
+			return m_sparse[id];
+		}
+
+		//! Return the element of an index, marked as changed
+		MUON_INLINE T& getMutable(m::i32 id)
+		{
+			MUON_ASSERT(has(id), "Index doesn't exists in Array!");
+			markChangedDense(m_sparse[id]);
+			return *address(m_sparse[id]);
+		}
+
+		MUON_INLINE void markChanged(m::i32 id)
+		{
+			MUON_ASSERT(has(id), "Index doesn't exists in Array!");
+			markChangedDense(m_sparse[id]);
+		}
+
+		//! Stamp the element at a dense position, and its chunk, with the current version
+		MUON_INLINE void markChangedDense(m::i32 pos)
+		{
+			m_versions[pos] = m_version;
+			m_chunkVersions[pos / CHANGE_CHUNK_SIZE] = m_version;
+		}
+
+		//! Version stamped by the next writes
+		MUON_INLINE m::u32 getVersion() const
+		{
+			return m_version;
+		}
+
+		/*!
+		* @brief Start a new version, and return it
+		* Every element written from now on will be changedSince() the returned value.
+		*/
+		MUON_INLINE m::u32 advanceVersion()
+		{
+			return ++m_version;
+		}
+
+		//! Return true if the element at a dense position was written at or after version
+		MUON_INLINE bool changedSince(m::i32 pos, m::u32 version) const
+		{
+			return m_versions[pos] >= version;
+		}
+
+		//! Return true if any element of a change chunk was written at or after version
+		MUON_INLINE bool chunkChangedSince(m::i32 chunk, m::u32 version) const
+		{
+			return m_chunkVersions[chunk] >= version;
+		}
+
+		MUON_INLINE m::i32 chunkCount() const
+		{
+			return (m_size + CHANGE_CHUNK_SIZE - 1) / CHANGE_CHUNK_SIZE;
+		}
+
+		//! Call func(T&) on every element changed since version, skipping unchanged chunks
+		template<typename Func>
+		void forEachChanged(m::u32 version, const Func& func)
+		{
+			for (m::i32 chunk = 0; chunk < chunkCount(); ++chunk)
+			{
+				if (!chunkChangedSince(chunk, version))
+				{
+					continue;
+				}
+				const m::i32 end = (chunk + 1) * CHANGE_CHUNK_SIZE < m_size ? (chunk + 1) * CHANGE_CHUNK_SIZE : m_size;
+				for (m::i32 pos = chunk * CHANGE_CHUNK_SIZE; pos < end; ++pos)
+				{
+					if (m_versions[pos] >= version)
+					{
+						func(*address(pos));
+					}
+				}
+			}
+		}
+
+		//! Return the number of times the index has been removed
+		MUON_INLINE m::u32 getGeneration(m::i32 id) const
+		{
+			MUON_ASSERT(id >= 0 && id < m_indexCount, "Index out of range!");
+			return m_generations[id];
+		}
+
+		//! Set the Entity owning an element
+		MUON_INLINE void setOwner(m::i32 id, EntityId owner)
+		{
+			MUON_ASSERT(has(id), "Index doesn't exists in Array!");
+			m_owners[m_sparse[id]] = owner;
+		}
+
+		//! Return the Entity owning the element at a dense position
+		MUON_INLINE EntityId getOwner(m::i32 pos) const
+		{
+			return m_owners[pos];
+		}
+
+		//! Return the owners of every element, in dense order [0..size()[
+		MUON_INLINE const EntityId* getOwners() const
+		{
+			return m_owners;
+		}
+
+		/*!
+		* @brief Return the dense position of an element from its address
+		* @return The position, or m::INVALID_INDEX if the element is not stored here
+		*/
+		m::i32 getPosition(const T* element) const
+		{
+			for (m::i32 i = 0; i < m_pageCount; ++i)
+			{
+				if (element >= m_pages[i] && element < m_pages[i] + pageSize())
+				{
+					m::i32 pos = (i << m_pageShift) + (m::i32)(element - m_pages[i]);
+					return (pos < m_size ? pos : m::INVALID_INDEX);
+				}
+			}
+			return m::INVALID_INDEX;
+		}
+
+		/*!
+		* @brief Exchange the elements at two dense positions
+		* Indices still refer to the same elements, only their addresses
+		* change: used to store elements in the order they are iterated.
+		* WARNING: pointers to both elements are invalidated, even when paged.
+		*/
+		void swapDense(m::i32 a, m::i32 b)
+		{
+			MUON_ASSERT(a >= 0 && a < m_size && b >= 0 && b < m_size, "Position out of range!");
+			if (a == b)
+			{
+				return;
+			}
+
+			typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type tmp;
+			detail::Relocator<T>::relocate((T*)&tmp, address(a));
+			detail::Relocator<T>::relocate(address(a), address(b));
+			detail::Relocator<T>::relocate(address(b), (T*)&tmp);
+			std::swap(m_dense[a], m_dense[b]);
+			std::swap(m_owners[a], m_owners[b]);
+			std::swap(m_versions[a], m_versions[b]);
+			m_sparse[m_dense[a]] = a;
+			m_sparse[m_dense[b]] = b;
+			// Moved elements keep their version, their new chunks must not hide it
+			const m::i32 positions[2] = { a, b };
+			for (m::i32 i = 0; i < 2; ++i)
+			{
+				m::u32& chunkVersion = m_chunkVersions[positions[i] / CHANGE_CHUNK_SIZE];
+				if (chunkVersion < m_versions[positions[i]])
+				{
+					chunkVersion = m_versions[positions[i]];
+				}
+			}
+		}
+
+		//! Return the first element of a page, elements in a page are contiguous
+		MUON_INLINE T* getPage(m::i32 page) const
+		{
+			return m_pages[page];
+		}
+
+		//! Return the number of elements a page can hold
+		MUON_INLINE m::i32 pageSize() const
+		{
+			return (m_growth == STORAGE_GROWTH_PAGED ? m_chunkSize : m_capacity);
+		}
+
+		MUON_INLINE m::i32 pageCount() const
+		{
+			return m_pageCount;
+		}
+
+		MUON_INLINE StorageGrowth growth() const
+		{
+			return m_growth;
+		}
+
 		MUON_INLINE m::i32 size() const
 		{
 			return m_size;
@@ -173,25 +647,197 @@ namespace ilg
 		}
 
 	private:
+		BasicComponentStorage(const BasicComponentStorage&);
+		BasicComponentStorage& operator=(const BasicComponentStorage&);
+
+		MUON_INLINE T* address(m::i32 pos) const
+		{
+			return m_pages[pos >> m_pageShift] + (pos & m_pageMask);
+		}
+
+		//! Destroy every element and free every buffer
+		void release()
+		{
+			for (m::i32 i = 0; i < m_size; ++i)
+			{
+				address(i)->~T();
+			}
+
+			for (m::i32 i = 0; i < m_pageCount; ++i)
+			{
+				free(m_pages[i]);
+			}
+			free(m_pages);
+			free(m_sparse);
+			free(m_dense);
+			free(m_owners);
+			free(m_generations);
+			free(m_versions);
+			free(m_chunkVersions);
+			m_pages = NULL;
+			m_sparse = NULL;
+			m_dense = NULL;
+			m_owners = NULL;
+			m_generations = NULL;
+			m_versions = NULL;
+			m_chunkVersions = NULL;
+			m_pageCount = 0;
+			m_capacity = 0;
+			m_size = 0;
+			m_indexCount = 0;
+		}
+
+		m::i32 allocIndex()
+		{
+			reallocBuffer();
+
+			//Recycle a previously removed index if there is one
+			m::i32 id = m_size;
+			if (m_size < m_indexCount)
+			{
+				id = m_dense[m_size];
+			}
+			else
+			{
+				m_generations[id] = 0;
+				++m_indexCount;
+			}
+			m_dense[m_size] = id;
+			m_sparse[id] = m_size;
+			m_owners[m_size] = INVALID_ENTITY;
+			if (m_size + 1 > m_peakSize)
+			{
+				m_peakSize = m_size + 1;
+			}
+			return id;
+		}
 
 		void reallocBuffer()
 		{
 			if (m_size >= m_capacity)
 			{
-				m_capacity += ChunkSize;
-				m::i32 newCapacity = sizeof(T) * m_capacity;
-				T* tmpbuff = (T*)realloc(m_buffer, newCapacity);
+				m::i32 capacity = m_capacity + m_chunkSize;
+				if (m_growth == STORAGE_GROWTH_GEOMETRIC && m_capacity > m_chunkSize)
+				{
+					capacity = m_capacity + m_capacity / 2;
+				}
+				setCapacity(capacity);
+			}
+		}
+
+		//! Resize every buffer to hold capacity elements, rounded to whole pages when paged
+		void setCapacity(m::i32 capacity)
+		{
+			MUON_ASSERT(capacity >= m_indexCount, "Capacity can't be lower than the index count!");
+			m::i32 oldCapacity = m_capacity;
+			++m_reallocCount;
+			if (m_growth == STORAGE_GROWTH_PAGED)
+			{
+				m::i32 pageCount = (capacity + m_chunkSize - 1) / m_chunkSize;
+				for (m::i32 i = pageCount; i < m_pageCount; ++i)
+				{
+					free(m_pages[i]);
+				}
+				T** tmpPages = (T**)realloc(m_pages, sizeof(T*) * pageCount);
+				MUON_ASSERT_BREAK(tmpPages != NULL
+								  , "Couldn't reallocate page table (Page count: %d)"
+								  , pageCount);
+				m_pages = tmpPages;
+				for (m::i32 i = m_pageCount; i < pageCount; ++i)
+				{
+					m_pages[i] = (T*)malloc(sizeof(T) * m_chunkSize);
+					MUON_ASSERT_BREAK(m_pages[i] != NULL
+									  , "Buffer can't be allocated (Size: %u)"
+									  , sizeof(T) * m_chunkSize);
+				}
+				m_pageCount = pageCount;
+				m_capacity = pageCount * m_chunkSize;
+			}
+			else
+			{
+				if (m_pageCount == 0)
+				{
+					m_pages = (T**)malloc(sizeof(T*));
+					MUON_ASSERT_BREAK(m_pages != NULL, "Couldn't allocate page table!");
+					m_pages[0] = NULL;
+					m_pageCount = 1;
+				}
+				T* tmpbuff = detail::Relocator<T>::reallocate(m_pages[0], m_size, capacity);
 				MUON_ASSERT_BREAK(tmpbuff != NULL
 								  , "Couldn't reallocate new buffer of size: %u (Old capacity: %u | Chunk: %u)"
-								  , newCapacity, m_capacity, ChunkSize);
-				m_buffer = tmpbuff;
+								  , sizeof(T) * capacity, oldCapacity, m_chunkSize);
+				m_pages[0] = tmpbuff;
+				m_capacity = capacity;
+			}
+
+			m::i32* tmpSparse = (m::i32*)realloc(m_sparse, sizeof(m::i32) * m_capacity);
+			m::i32* tmpDense = (m::i32*)realloc(m_dense, sizeof(m::i32) * m_capacity);
+			EntityId* tmpOwners = (EntityId*)realloc(m_owners, sizeof(EntityId) * m_capacity);
+			m::u32* tmpGenerations = (m::u32*)realloc(m_generations, sizeof(m::u32) * m_capacity);
+			m::u32* tmpVersions = (m::u32*)realloc(m_versions, sizeof(m::u32) * m_capacity);
+			MUON_ASSERT_BREAK(tmpSparse != NULL && tmpDense != NULL && tmpOwners != NULL && tmpGenerations != NULL && tmpVersions != NULL
+							  , "Couldn't reallocate index arrays (Capacity: %d)"
+							  , m_capacity);
+			m_sparse = tmpSparse;
+			m_dense = tmpDense;
+			m_owners = tmpOwners;
+			m_generations = tmpGenerations;
+			m_versions = tmpVersions;
+
+			m::i32 oldChunks = (oldCapacity + CHANGE_CHUNK_SIZE - 1) / CHANGE_CHUNK_SIZE;
+			m::i32 newChunks = (m_capacity + CHANGE_CHUNK_SIZE - 1) / CHANGE_CHUNK_SIZE;
+			if (newChunks != oldChunks)
+			{
+				m::u32* tmpChunkVersions = (m::u32*)realloc(m_chunkVersions, sizeof(m::u32) * newChunks);
+				MUON_ASSERT_BREAK(tmpChunkVersions != NULL
+								  , "Couldn't reallocate change chunks (Count: %d)"
+								  , newChunks);
+				m_chunkVersions = tmpChunkVersions;
+				if (newChunks > oldChunks)
+				{
+					memset(m_chunkVersions + oldChunks, 0, sizeof(m::u32) * (newChunks - oldChunks));
+				}
 			}
 		}
 
+		m::i32 m_chunkSize;
+		StorageGrowth m_growth;
+		m::i32 m_pageShift;
+		m::i32 m_pageMask;
+
 		m::i32 m_capacity;
 		m::i32 m_size;
-		std::unordered_map<m::i32, T*> m_index;
-		T* m_buffer;
+		m::i32 m_indexCount;
+		m::i32 m_pageCount;
+		T** m_pages;
+		m::i32* m_sparse;
+		m::i32* m_dense;
+		EntityId* m_owners;
+		m::u32* m_generations;
+		m::u32 m_version;
+		m::u32* m_versions;
+		m::u32* m_chunkVersions;
+		m::i32 m_peakSize;
+		m::u32 m_reallocCount;
+	};
+
+	/*!
+	* @brief BasicComponentStorage with compile-time growth parameters
+	* @template T Component you want to store
+	* @template ChunkSize How the Array will grow when reaching its memory limit
+	* @template Growth Whether the array is a single buffer or a set of pages
+	*/
+	template<typename T, m::i32 ChunkSize, StorageGrowth Growth = STORAGE_GROWTH_FIXED>
+	class ComponentStorage : public BasicComponentStorage<T>
+	{
+		static_assert(ChunkSize > 0, "Creating 0 Chunk-size!");
+		static_assert(Growth != STORAGE_GROWTH_PAGED || (ChunkSize & (ChunkSize - 1)) == 0
+					  , "Paged storage requires a power of two Chunk-size!");
+	public:
+		ComponentStorage()
+			: BasicComponentStorage<T>(ChunkSize, Growth)
+		{
+		}
 	};
 }
 
@@ -29,76 +29,209 @@
 #define INCLUDE_ILARGIA_ENTITY_HPP
 
 #include <deque>
+#include <vector>
 #include <Muon/Helper/NonCopyable.hpp>
 #include <Muon/Helper/Singleton.hpp>
 #include "Ilargia/Component/Component.hpp"
-#include "Ilargia/Component/ComponentStorage.hpp"
+#include "Ilargia/Component/ComponentMask.hpp"
+#include "Ilargia/Component/EntityId.hpp"
+#include "Ilargia/Component/EntityEvent.hpp"
 
 namespace ilg
 {
 	class EntityManager;
+	class ArchetypeStorage;
+	class CommandBuffer;
+	class WorldSnapshot;
+	class WorldStreamer;
+	class Prefab;
+	template<typename...> class View;
 	class ILARGIA_API Entity : public m::helper::NonCopyable
 	{
 		friend class EntityManager;
-		friend class m::memory::RawAllocator<Entity>;
-		Entity();
+		friend class CommandBuffer;
+		friend class WorldSnapshot;
+		friend class WorldStreamer;
+		friend class Prefab;
+		template<typename...> friend class View;
+		Entity(EntityId id);
 	public:
 		~Entity();
 
 		static Entity* create();
 		static void destroy(Entity* entity);
 
+		EntityId getId() const;
+
+		// Hierarchy changes link entities and queue a HierarchyEvent without any lock:
+		// they are only allowed on the main thread, workers record them in a CommandBuffer
 		void setParent(Entity* parent);
 		void addChild(Entity* child);
 
 		void removeParent();
 		void removeChild(Entity* child);
 
+		Entity* getParent() const;
+		Entity* getFirstChild() const;
+		Entity* getLastChild() const;
+		Entity* getNextSibling() const;
+		Entity* getPrevSibling() const;
+		m::u32 getChildCount() const;
+
+		/*!
+		* @brief Return the next Entity of the subtree of root, in depth-first order
+		* Starting from root, this walks every descendant without any stack:
+		* for (Entity* e = root->getFirstChild(); e; e = e->getNextInHierarchy(root)) { ... }
+		* @return NULL once every descendant of root has been visited
+		*/
+		Entity* getNextInHierarchy(const Entity* root) const;
+
 		template<typename T>
 		Component addComponent()
 		{
-			return _addComponent(MUON_TRAITS(T)::id());
+			return _addComponent(manager::getComponentTypeIndex<T>());
 		}
 
 		template<typename T>
-		Component getComponent()
+		MUON_INLINE bool hasComponent() const
 		{
-			return _getComponent(MUON_TRAITS(T)::id());
+			return m_componentMask.test(manager::getComponentTypeIndex<T>());
 		}
 
 		template<typename T>
-		bool removeComponent()
+		MUON_INLINE Component getComponent() const
 		{
-			return _removeComponent(MUON_TRAITS(T)::id());
+			return _getComponent(manager::getComponentTypeIndex<T>());
 		}
 
-	private:
+		template<typename T>
+		bool removeComponent()
+		{
+			return _removeComponent(manager::getComponentTypeIndex<T>());
+		}
 
-		ComponentStorage<Component, 8>* m_components;
+		//! Return the set of Component types of the Entity, by dense type index
+		MUON_INLINE const ComponentMask& getComponentMask() const
+		{
+			return m_componentMask;
+		}
 
+	private:
+		EntityId m_id;
+		bool m_alive;
+
+		// Handles are packed in type index order: the one of a type set in
+		// m_componentMask is at m_componentMask.rank(type). The first ones are
+		// held inline, so most entities never allocate; past
+		// ILARGIA_ENTITY_INLINE_COMPONENTS they all move to m_heapComponents
+		ComponentMask m_componentMask;
+		Component m_inlineComponents[ILARGIA_ENTITY_INLINE_COMPONENTS];
+		Component* m_heapComponents;
+		m::u32 m_heapCapacity;
+
+		// Children are an intrusive doubly linked list: no allocation,
+		// and linking or unlinking an Entity is O(1)
 		Entity* m_parent;
-		std::deque<Entity*>* m_children;
+		Entity* m_firstChild;
+		Entity* m_lastChild;
+		Entity* m_prevSibling;
+		Entity* m_nextSibling;
+		m::u32 m_childCount;
+
+		void _link(Entity* parent);
+		void _unlink();
+
+		Component _addComponent(m::u32);
+		//! Record a Component already owned by the Entity, without notifying its manager
+		void _bindComponent(const Component&);
+		bool _removeComponent(m::u32);
+		void _removeAllComponents();
+
+		MUON_INLINE Component _getComponent(m::u32 typeIndex) const
+		{
+			return (m_componentMask.test(typeIndex) ? _getHandles()[m_componentMask.rank(typeIndex)] : Component());
+		}
 
-		Component _addComponent(m::u64);
-		Component _getComponent(m::u64);
-		bool _removeComponent(m::u64);
+		MUON_INLINE Component* _getHandles()
+		{
+			return (m_heapComponents != NULL ? m_heapComponents : m_inlineComponents);
+		}
+
+		MUON_INLINE const Component* _getHandles() const
+		{
+			return (m_heapComponents != NULL ? m_heapComponents : m_inlineComponents);
+		}
 	};
 
+	/*!
+	* @brief Create, destroy and keep track of every Entity
+	* Entities are allocated in pages of ENTITY_PAGE_SIZE and never freed:
+	* destroying an Entity puts its slot in a free list, recycled by
+	* the next create() call. Create, destroy and isAlive are O(1).
+	*/
 	class ILARGIA_API EntityManager : public m::helper::NonCopyable
 	{
 		friend class Entity;
 	public:
 		MUON_SINGLETON_GET(EntityManager);
 
+		static const m::u32 ENTITY_PAGE_SIZE = 1024;
+
 		Entity* create();
+
+		/*!
+		* @brief Create count entities at once
+		* Free slots are recycled first, then every missing page is allocated
+		* in one go: cheaper than count calls to create().
+		* @param out Receives the created entities, must hold count pointers
+		*/
+		void create(Entity** out, m::u32 count);
+
 		void destroy(Entity* e);
+		void destroy(EntityId id);
+
+		//! Return true if the id refers to a living Entity
+		bool isAlive(EntityId id) const;
+
+		//! Return the Entity matching the id, or NULL if it has been destroyed
+		Entity* get(EntityId id) const;
+
+		//! Return the number of living entities
+		m::u32 getCount() const;
+
+		//! Return the number of slots ever allocated, living entities have an index below it
+		m::u32 getSlotCount() const;
+
+		//! Return the living Entity using a slot, or NULL, see getEntityIndex()
+		Entity* getFromSlot(m::u32 index) const;
+
+		/*!
+		* @brief Deliver the events queued since the last call
+		* Each manager subscribed to an event kind receives every queued event
+		* of that kind in one call. Called by the Engine once per frame.
+		*/
+		void flushEvents();
+
+		/*!
+		* @brief Storage shared by the managers using archetypes, see IArchetypeManager
+		* An Entity is registered when it gets its first Component from such a
+		* manager, and unregistered when destroyed.
+		*/
+		ArchetypeStorage& getArchetypeStorage() const;
 
 	private:
 		EntityManager();
 		~EntityManager();
 
+		Entity* _getSlot(m::u32 index) const;
+
 		void dispatchEntityHierarchyChange(Entity*, Entity*, Entity*);
-		std::deque<Entity*>* m_entities;
+		std::vector<HierarchyEvent>* m_hierarchyEvents;
+		std::vector<Entity*>* m_pages;
+		std::deque<m::u32>* m_freeSlots;
+		ArchetypeStorage* m_archetypeStorage;
+		m::u32 m_slotCount;
+		m::u32 m_aliveCount;
 	};
 }
 
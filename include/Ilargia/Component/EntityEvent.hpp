@@ -0,0 +1,59 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_ENTITYEVENT_HPP
+#define INCLUDE_ILARGIA_ENTITYEVENT_HPP
+
+#include "Ilargia/Component/EntityId.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief Kinds of Entity events a manager can subscribe to
+	* Values are bits, combined in the mask given to IBaseManager::subscribe().
+	*/
+	enum EntityEventType
+	{
+		ENTITY_EVENT_NONE = 0,
+		ENTITY_EVENT_HIERARCHY = 1 << 0,	//!< See IBaseManager::onEntityHierarchyChanged()
+	};
+
+	/*!
+	* @brief The parent of an Entity changed
+	* Ids are used rather than pointers as the event is delivered later:
+	* any of them may refer to an Entity destroyed in the meantime
+	* (see EntityManager::get()). A parent is INVALID_ENTITY for none.
+	*/
+	struct HierarchyEvent
+	{
+		EntityId entity;
+		EntityId previousParent;
+		EntityId newParent;
+	};
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_ENTITYID_HPP
+#define INCLUDE_ILARGIA_ENTITYID_HPP
+
+#include "Ilargia/Core/Define.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief Identify an Entity
+	* The lower ENTITY_INDEX_BITS bits are the slot of the Entity in the
+	* EntityManager, the upper bits are the generation of the slot,
+	* incremented each time an Entity using this slot is destroyed.
+	* An EntityId referring to a destroyed Entity is thus never valid again,
+	* even if its slot has been recycled.
+	*/
+	typedef m::u32 EntityId;
+
+	static const m::u32 ENTITY_INDEX_BITS = 22;
+	static const m::u32 ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+	static const m::u32 ENTITY_GENERATION_BITS = 32 - ENTITY_INDEX_BITS;
+	static const m::u32 ENTITY_GENERATION_MASK = (1u << ENTITY_GENERATION_BITS) - 1;
+	static const EntityId INVALID_ENTITY = 0xFFFFFFFF;
+
+	MUON_INLINE m::u32 getEntityIndex(EntityId id)
+	{
+		return id & ENTITY_INDEX_MASK;
+	}
+
+	MUON_INLINE m::u32 getEntityGeneration(EntityId id)
+	{
+		return id >> ENTITY_INDEX_BITS;
+	}
+
+	MUON_INLINE EntityId makeEntityId(m::u32 index, m::u32 generation)
+	{
+		return (index & ENTITY_INDEX_MASK) | ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS);
+	}
+}
+
+#endif
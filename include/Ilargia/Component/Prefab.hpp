@@ -0,0 +1,110 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#ifndef INCLUDE_ILARGIA_PREFAB_HPP
+#define INCLUDE_ILARGIA_PREFAB_HPP
+
+#include <vector>
+#include <Muon/Helper/NonCopyable.hpp>
+#include "Ilargia/Component/Entity.hpp"
+#include "Ilargia/Manager/ComponentTypeIndex.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief Template of entities, to be spawned many times
+	* A Prefab is a small hierarchy of nodes, each with a set of components
+	* and their default values. Default values are kept column-wise, one
+	* column per Component type, so instantiate() can create every copy
+	* in one go: entity slots are allocated at once, then each column is
+	* copied in its storage with a single IBaseManager::cloneComponents()
+	* and a single IBaseManager::onComponentsAdded() call.
+	*
+	* Only trivially copyable components (see IBaseManager::isComponentSerializable())
+	* can be part of a Prefab. They are captured byte per byte: each copy gets
+	* its Component handle base and per-run fields reset, see onComponentLoaded().
+	* @code
+	* Prefab enemy;
+	* m::u32 body = enemy.addNode();
+	* enemy.setComponent(body, Transform());
+	* enemy.setComponent(enemy.addNode(body), Weapon());
+	* enemy.instantiate(2000);
+	* @endcode
+	*/
+	class ILARGIA_API Prefab : public m::helper::NonCopyable
+	{
+	public:
+		static const m::u32 PREFAB_NO_PARENT = 0xFFFFFFFF;
+
+		Prefab();
+		~Prefab();
+
+		/*!
+		* @brief Add an Entity to the template
+		* @param parent A node added before, or PREFAB_NO_PARENT for a root
+		* @return Index of the node
+		*/
+		m::u32 addNode(m::u32 parent = PREFAB_NO_PARENT);
+		m::u32 getNodeCount() const;
+
+		//! Give a T Component with the given default value to a node, replacing the previous one
+		template<typename T>
+		bool setComponent(m::u32 node, const T& value = T())
+		{
+			return _setComponent(manager::getComponentTypeIndex<T>(), node, &value, sizeof(T));
+		}
+
+		//! Rebuild the template from an Entity and its descendants, with their current component values
+		void capture(const Entity* root);
+
+		void clear();
+
+		/*!
+		* @brief Create count copies of the template
+		* @param created If not NULL, receives every created Entity, copy after copy, in node order
+		*/
+		void instantiate(m::u32 count, std::vector<Entity*>* created = NULL) const;
+
+	private:
+		struct Column
+		{
+			manager::IBaseManager* manager;
+			m::u32 elementSize;
+			std::vector<m::u32> nodes;
+			std::vector<m::u8> data;
+		};
+		typedef std::vector<Column> ColumnList;
+
+		bool _setComponent(m::u32 typeIndex, m::u32 node, const void* value, m::u32 size);
+
+		std::vector<m::u32>* m_parents;
+		ColumnList* m_columns;
+	};
+}
+
+#endif
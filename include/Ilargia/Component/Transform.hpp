@@ -28,6 +28,7 @@
 #ifndef INCLUDE_ILARGIA_TRANSFORM_HPP
 #define INCLUDE_ILARGIA_TRANSFORM_HPP
 
+#include <vector>
 #include <Muon/Helper/NonCopyable.hpp>
 #include <Muon/Traits/TypeTraits.hpp>
 #include "Ilargia/Manager/IComponentManager.hpp"
@@ -37,26 +38,134 @@
 #include "Ilargia/Type/Vector.hpp"
 #include "Ilargia/Type/Quaternion.hpp"
 #include "Ilargia/Type/Matrix.hpp"
+#include "Ilargia/Type/AffineMatrix.hpp"
+#include "Ilargia/Type/TransformBatch.hpp"
 
 namespace ilg
 {
+	enum TransformFlag
+	{
+		TRANSFORM_LOCAL_DIRTY = 1 << 0,	//!< Position, scale or rotation changed since the last update
+		TRANSFORM_WORLD_DIRTY = 1 << 1,	//!< World matrix must be computed again, as well as the ones of its children
+	};
+
+	//! What the last TransformComponentManager update did
+	struct TransformUpdateStats
+	{
+		m::u32 transformCount;
+		m::u32 updatedCount;	//!< World matrices computed again
+		m::u32 dirtySubtrees;	//!< Subtrees visited, each starting at a dirty Transform
+		m::u32 workItems;		//!< Ranges of Transform computed, dispatched to the JobSystem workers
+		bool rebuilt;			//!< The sorted list was rebuilt, every matrix was computed
+	};
+
 	ILARGIA_COMPONENT_DECL(Transform)
 	{
 		ILARGIA_COMPONENT_FRIEND_MANAGER(Transform);
 	public:
 		Transform();
-		~Transform();
 
-		Vector position;
-		Vector scale;
-		Quaternion rotation;
+		MUON_INLINE const Vector& getPosition() const
+		{
+			return m_position;
+		}
+
+		MUON_INLINE const Vector& getScale() const
+		{
+			return m_scale;
+		}
+
+		MUON_INLINE const Quaternion& getRotation() const
+		{
+			return m_rotation;
+		}
+
+		//! Setters flag the Transform, so only dirty subtrees are updated
+		MUON_INLINE void setPosition(const Vector& position)
+		{
+			m_position = position;
+			_setDirty();
+		}
+
+		MUON_INLINE void setScale(const Vector& scale)
+		{
+			m_scale = scale;
+			_setDirty();
+		}
 
+		MUON_INLINE void setRotation(const Quaternion& rotation)
+		{
+			m_rotation = rotation;
+			_setDirty();
+		}
+
+		//! Mask of TransformFlag
+		MUON_INLINE m::u32 getFlags() const
+		{
+			return m_flags;
+		}
+
+		//! World matrix, as computed by the last TransformComponentManager update
+		MUON_INLINE const AffineMatrix& getAffineMatrix() const
+		{
+			return m_model;
+		}
+
+		//! Same as getAffineMatrix(), as a 4x4 Matrix
 		Matrix getMatrix() const;
 	private:
-		Matrix		m_model;
+		MUON_INLINE void _setDirty()
+		{
+			if (!(m_flags & TRANSFORM_LOCAL_DIRTY))
+			{
+				_queueDirty();
+			}
+		}
+		void _queueDirty();
+
+		ILARGIA_COMPONENT_HAS_STATIC_MANAGER(Transform, s_manager);
+
+		Vector			m_position;
+		Vector			m_scale;
+		Quaternion		m_rotation;
+		AffineMatrix	m_model;
+		m::i32			m_sortedIndex;
+		m::u32			m_flags;
 	};
 
-	ILARGIA_COMPONENT_MANAGER_DECL_SIZE(Transform, 256)
+	/*!
+	* @brief Compute the world matrix of every Transform
+	* The parent of a Transform is the Transform of the closest ancestor
+	* of its Entity having one. Transforms are kept in a flat list sorted
+	* depth-first, a parent always coming before its children, so world
+	* matrices are computed in one forward pass: each Transform reads the
+	* already computed matrix of its parent, there is no recursion.
+	* Adding or removing a Transform, or changing the Entity hierarchy,
+	* patches that list in place: the affected subtree is moved to the end
+	* of its new parent one, and only it is computed again. Past a few such
+	* changes in a frame (loading, instantiating), the list is rebuilt.
+	* The update reads the Transforms through that list, in storage order:
+	* as the storage is paged, a Transform* stays valid across frames (until
+	* that Transform is removed, or the last one is moved in its place).
+	* setStorageSorted(true) trades that for linear reads: each rebuild then
+	* moves the Transforms in the storage so they are stored in list order.
+	* WARNING: a rebuild happens on any frame with many hierarchy or
+	* Transform changes, and invalidates every Transform* when enabled: only
+	* keep Component handles then. Patched subtrees stay out of that order
+	* until the next rebuild.
+	*
+	* As a subtree is contiguous in that list, only the subtrees of the
+	* Transform modified through a setter (queued per thread, see
+	* JobSystem::getThreadIndex()) are computed again, unless the list was
+	* rebuilt. Static parts of the scene cost nothing.
+	*
+	* Subtrees to compute are independent: they are grouped in work items
+	* of similar size, computed on the JobSystem workers. A subtree too big
+	* for one work item (a single huge root) is split level by level: its
+	* root is computed first, then its children subtrees in parallel.
+	*/
+
+	ILARGIA_COMPONENT_MANAGER_DECL_SIZE(Transform, 256, STORAGE_GROWTH_PAGED)
 	{
 	public:
 		ILARGIA_COMPONENT_MANAGER_NAME(Transform)();
@@ -67,21 +176,80 @@ namespace ilg
 		virtual void onTerm();
 
 		virtual void onComponentAdded(Entity* entity, Component& component);
-		virtual void onComponentRemoved(Entity* entity, Component& component);
+		virtual void onComponentsAdded(Entity* const* entities, Component* components, m::u32 count);
 
 		virtual Component createComponent();
 		virtual void destroyComponent(Component& component);
 		virtual void* getComponent(m::i32 index);
 		virtual Component getComponent(void* object);
 
-		virtual void onEntityHierarchyChanged(Entity* entity, Entity* previousParent, Entity* newParent);
+		virtual void onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count);
+
+		const TransformUpdateStats& getUpdateStats() const;
+
+		/*!
+		* @brief Store the Transforms in update order on each rebuild, off by default
+		* Faster updates, but every Transform* is invalidated on rebuilds.
+		*/
+		void setStorageSorted(bool sorted);
+		bool isStorageSorted() const;
+	protected:
+		//! Sorted index and flags come from the run that saved the Transform
+		virtual void onComponentLoaded(Transform& component);
 	private:
+		friend class Transform;
+		//! Rebuild the sorted list, if the hierarchy or the Transform set changed
 		void updateRootList();
-		void updateRecursive(Component& component);
+		//! Count a local change of the sorted list, false if a rebuild is pending or cheaper
+		bool canPatch();
+		Transform* transformOf(Entity* entity) const;
+		//! Add a Transform not sorted yet at the end of the list, as a root
+		void appendTransform(Transform* transform);
+		//! Move the subtree of the Transform of an Entity under the one of its closest ancestor
+		void relinkTransform(Entity* entity);
+		//! Same for the closest Transforms below an Entity
+		void relinkChildren(Entity* entity);
+		//! Make the subtree at index the last child of parent (-1 for a root)
+		void moveSubtree(m::i32 index, m::i32 parent);
+		//! Remove a Transform from the list, its children get its parent
+		void eraseTransform(m::i32 index);
+		//! Compute the world matrices of m_sortedTransforms in [begin, end)
+		void updateWorldMatrices(m::i32 begin, m::i32 end);
+		void updateDirtySubtrees();
+		//! Compute the subtrees starting at each index of m_subtreeStarts, in parallel if worth it
+		void updateSubtrees();
+
+		//! Work item: range of m_subtreeStarts
+		struct UpdateRange
+		{
+			m::i32 begin;
+			m::i32 end;
+		};
 
 		bool m_requireRootListUpdate;
+		bool m_storageSorted;
+		//! Local changes of the sorted list since the last update
+		m::u32 m_patchCount;
 
-		ComponentStorage<Component, 64>* m_rootTransforms;
+		// Sorted depth-first, with the index in m_sortedTransforms of each parent (-1 for roots)
+		std::vector<Transform*>* m_sortedTransforms;
+		std::vector<m::i32>* m_parentIndices;
+		//! Index in m_sortedTransforms of each root, filled by updateRootList()
+		std::vector<m::u32>* m_rootTransforms;
+		//! Number of Transform in the subtree starting at each index of m_sortedTransforms
+		std::vector<m::u32>* m_subtreeSizes;
+		//! Scratch buffer: index in m_sortedTransforms of each dense position
+		std::vector<m::i32>* m_sortedIndices;
+		//! Index in m_sortedTransforms of the Transform flagged TRANSFORM_LOCAL_DIRTY, one list per thread
+		std::vector<std::vector<m::i32> >* m_dirtyTransforms;
+		std::vector<m::i32>* m_dirtyIndices;
+		//! Subtrees to compute (sorted), then the ones of the next level when splitting a big subtree
+		std::vector<m::i32>* m_subtreeStarts;
+		std::vector<m::i32>* m_nextStarts;
+		std::vector<UpdateRange>* m_ranges;
+		//! One TransformBatch per thread, see JobSystem::getThreadIndex()
+		std::vector<TransformBatch>* m_batches;
+		TransformUpdateStats m_stats;
 	};
 }
 MUON_TRAITS_DECL(ilg::Transform);
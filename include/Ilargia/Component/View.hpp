@@ -0,0 +1,252 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_VIEW_HPP
+#define INCLUDE_ILARGIA_VIEW_HPP
+
+#include <tuple>
+#include "Ilargia/Component/ComponentStorage.hpp"
+#include "Ilargia/Component/Entity.hpp"
+#include "Ilargia/Manager/ManagerFactory.hpp"
+
+namespace ilg
+{
+	namespace detail
+	{
+		template<m::u32... I>
+		struct IndexList
+		{
+		};
+
+		template<m::u32 N, m::u32... I>
+		struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...>
+		{
+		};
+
+		template<m::u32... I>
+		struct MakeIndexList<0, I...>
+		{
+			typedef IndexList<I...> Type;
+		};
+
+		template<typename T, typename ...List>
+		struct TypeIndex;
+
+		template<typename T, typename ...List>
+		struct TypeIndex<T, T, List...>
+		{
+			enum { value = 0 };
+		};
+
+		template<typename T, typename U, typename ...List>
+		struct TypeIndex<T, U, List...>
+		{
+			enum { value = 1 + TypeIndex<T, List...>::value };
+		};
+	}
+
+	/*!
+	* @brief Iterate over every Entity having all the given Component types
+	* The storage with the fewest components drives the iteration: each of
+	* its owners is matched against the ComponentMask of the View (a single
+	* AND per mask word), then its components are fetched from the Entity
+	* slots. Storages are fetched once when the View is created, there is
+	* no virtual call while iterating.
+	*
+	* Components must not be added or removed (on any of the viewed types)
+	* while iterating.
+	* @code
+	* auto view = World::getInstance().view<Transform, Velocity>();
+	* view.each([](Entity* e, Transform& t, Velocity& v) { ... });
+	* for (Entity* e : view) { view.get<Transform>(e); }
+	* @endcode
+	*/
+	template<typename ...Types>
+	class View
+	{
+		static_assert(sizeof...(Types) > 0, "A View requires at least one Component type!");
+		typedef typename detail::MakeIndexList<sizeof...(Types)>::Type Indices;
+		typedef std::tuple<BasicComponentStorage<Types>*...> StorageList;
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(const View* view, m::i32 pos)
+				: m_view(view)
+				, m_pos(pos)
+				, m_entity(NULL)
+			{
+				_next();
+			}
+
+			MUON_INLINE Entity* operator*() const
+			{
+				return m_entity;
+			}
+
+			MUON_INLINE Iterator& operator++()
+			{
+				++m_pos;
+				_next();
+				return *this;
+			}
+
+			MUON_INLINE bool operator!=(const Iterator& it) const
+			{
+				return m_pos != it.m_pos;
+			}
+
+		private:
+			void _next()
+			{
+				m_entity = NULL;
+				for (; m_pos < m_view->m_count; ++m_pos)
+				{
+					Entity* entity = m_view->_getEntity(m_pos);
+					if (entity != NULL && entity->getComponentMask().contains(m_view->m_mask))
+					{
+						m_entity = entity;
+						return;
+					}
+				}
+			}
+
+			const View* m_view;
+			m::i32 m_pos;
+			Entity* m_entity;
+		};
+
+		View()
+			: m_storages(_fetchStorage<Types>()...)
+			, m_typeIndices{ manager::getComponentTypeIndex<Types>()... }
+			, m_owners(NULL)
+			, m_count(0)
+		{
+			for (m::u32 i = 0; i < sizeof...(Types); ++i)
+			{
+				if (m_typeIndices[i] < ILARGIA_MAX_COMPONENT_TYPES)
+				{
+					m_mask.set(m_typeIndices[i]);
+				}
+			}
+			_pickDriver(Indices());
+		}
+
+		/*!
+		* @brief Call func(Entity*, Types&...) for every matching Entity
+		*/
+		template<typename Func>
+		void each(Func func) const
+		{
+			for (m::i32 pos = 0; pos < m_count; ++pos)
+			{
+				Entity* entity = _getEntity(pos);
+				if (entity != NULL && entity->getComponentMask().contains(m_mask))
+				{
+					_visit(func, entity, Indices());
+				}
+			}
+		}
+
+		//! Return the T Component of an Entity returned by the View
+		template<typename T>
+		MUON_INLINE T& get(Entity* entity) const
+		{
+			return std::get<detail::TypeIndex<T, Types...>::value>(m_storages)->get(entity->_getComponent(m_typeIndices[detail::TypeIndex<T, Types...>::value]).getInstanceIndex());
+		}
+
+		//! Upper bound of the number of matching entities
+		MUON_INLINE m::i32 sizeHint() const
+		{
+			return m_count;
+		}
+
+		Iterator begin() const
+		{
+			return Iterator(this, 0);
+		}
+
+		Iterator end() const
+		{
+			return Iterator(this, m_count);
+		}
+
+	private:
+		template<typename T>
+		static BasicComponentStorage<T>* _fetchStorage()
+		{
+			manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManager<T>();
+			return (manager != NULL ? manager->getComponentStorage<T>() : NULL);
+		}
+
+		template<m::u32... I>
+		void _pickDriver(detail::IndexList<I...>)
+		{
+			// Any missing storage means no Entity can match
+			const bool valid[] = { (std::get<I>(m_storages) != NULL)... };
+			for (m::u32 i = 0; i < sizeof...(Types); ++i)
+			{
+				if (!valid[i])
+				{
+					return;
+				}
+			}
+
+			const m::i32 sizes[] = { std::get<I>(m_storages)->size()... };
+			const EntityId* owners[] = { std::get<I>(m_storages)->getOwners()... };
+			m_count = sizes[0];
+			m_owners = owners[0];
+			for (m::u32 i = 1; i < sizeof...(Types); ++i)
+			{
+				if (sizes[i] < m_count)
+				{
+					m_count = sizes[i];
+					m_owners = owners[i];
+				}
+			}
+		}
+
+		MUON_INLINE Entity* _getEntity(m::i32 pos) const
+		{
+			return EntityManager::getInstance().get(m_owners[pos]);
+		}
+
+		template<typename Func, m::u32... I>
+		void _visit(Func& func, Entity* entity, detail::IndexList<I...>) const
+		{
+			func(entity, std::get<I>(m_storages)->get(entity->_getComponent(m_typeIndices[I]).getInstanceIndex())...);
+		}
+
+		StorageList m_storages;
+		m::u32 m_typeIndices[sizeof...(Types)];
+		ComponentMask m_mask;
+		const EntityId* m_owners;
+		m::i32 m_count;
+	};
+}
+
+#endif
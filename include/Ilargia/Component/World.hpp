@@ -0,0 +1,60 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_WORLD_HPP
+#define INCLUDE_ILARGIA_WORLD_HPP
+
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/Helper/Singleton.hpp>
+#include "Ilargia/Component/View.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief Entry point to query entities by their Component set
+	*/
+	class ILARGIA_API World : public m::helper::NonCopyable
+	{
+	public:
+		MUON_SINGLETON_GET(World);
+
+		/*!
+		* @brief Return a View over every Entity having all the given Component types
+		*/
+		template<typename ...Types>
+		View<Types...> view() const
+		{
+			return View<Types...>();
+		}
+
+	private:
+		World();
+		~World();
+	};
+}
+
+#endif
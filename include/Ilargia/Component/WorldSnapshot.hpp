@@ -0,0 +1,141 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_WORLDSNAPSHOT_HPP
+#define INCLUDE_ILARGIA_WORLDSNAPSHOT_HPP
+
+#include <vector>
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/Meta/MetaDatabase.hpp>
+#include <Muon/String.hpp>
+#include "Ilargia/Component/Entity.hpp"
+#include "Ilargia/System/MappedFile.hpp"
+
+namespace ilg
+{
+	//! First bytes of a snapshot file
+	struct SnapshotHeader
+	{
+		m::u32 magic;
+		m::u32 version;
+		m::u32 entityCount;
+		m::u32 columnCount;
+		m::u64 parentsOffset;	//!< entityCount m::u32, see WorldSnapshot::getParents()
+		m::u64 columnsOffset;	//!< columnCount SnapshotColumn
+	};
+
+	//! Every component of a type, stored contiguously
+	struct SnapshotColumn
+	{
+		m::u64 type;			//!< MUON_TRAITS_ID of the Component
+		m::u32 elementSize;
+		m::u32 count;
+		m::u64 ownersOffset;	//!< count m::u32, snapshot index of the Entity owning each component
+		m::u64 dataOffset;		//!< count * elementSize bytes, aligned on SNAPSHOT_ALIGNMENT
+	};
+
+	/*!
+	* @brief Binary save of the entities, their hierarchy and their components
+	* The file is made of the SnapshotHeader, the parent of each Entity
+	* (entities are stored depth-first, a parent always comes before its
+	* children), then one SnapshotColumn per Component type, each pointing
+	* to the owners and the raw bytes of its components.
+	* Only components whose manager isComponentSerializable() are saved.
+	*
+	* Loading maps the file in memory (see system::MappedFile): columns can
+	* be read in place with getColumn(), and instantiate() creates every
+	* Entity and bulk-copies each column in the storage of its manager, which
+	* gets a single IBaseManager::onComponentsAdded() call per column.
+	* The file must be read by a build with the same Component layouts:
+	* element sizes are checked, a mismatching column is skipped.
+	* The Component handle base of each loaded component is reset, and so
+	* are the fields its manager resets in onComponentLoaded().
+	*/
+	class ILARGIA_API WorldSnapshot : public m::helper::NonCopyable
+	{
+	public:
+		static const m::u32 SNAPSHOT_MAGIC = 0x53474C49; // "ILGS"
+		static const m::u32 SNAPSHOT_VERSION = 1;
+		static const m::u32 SNAPSHOT_ALIGNMENT = 16;
+		static const m::u32 SNAPSHOT_NO_PARENT = 0xFFFFFFFF;
+
+		//! Write every living Entity
+		static bool save(const m::String& filename);
+
+		WorldSnapshot();
+		~WorldSnapshot();
+
+		//! Map a snapshot file, and check its header, offsets and component owners
+		bool open(const m::String& filename);
+		void close();
+		bool isOpen() const;
+
+		//! Read the whole file in memory now, see system::MappedFile::prefetch()
+		void prefetch() const;
+
+		m::u32 getEntityCount() const;
+		//! Snapshot index of the parent of each Entity, SNAPSHOT_NO_PARENT for roots
+		const m::u32* getParents() const;
+
+		m::u32 getColumnCount() const;
+		const SnapshotColumn& getColumn(m::u32 column) const;
+		const m::u32* getColumnOwners(m::u32 column) const;
+		const void* getColumnData(m::u32 column) const;
+
+		//! Manager able to load a column, or NULL if its type is unknown or its layout changed
+		manager::IBaseManager* getColumnManager(m::u32 column) const;
+
+		//! Components of type T, read in place from the file, or NULL if none were saved
+		template<typename T>
+		const T* getColumn(m::u32& count) const
+		{
+			for (m::u32 i = 0; i < getColumnCount(); ++i)
+			{
+				const SnapshotColumn& column = getColumn(i);
+				if (column.type == MUON_TRAITS_ID(T) && column.elementSize == sizeof(T))
+				{
+					count = column.count;
+					return (const T*)getColumnData(i);
+				}
+			}
+			count = 0;
+			return NULL;
+		}
+
+		/*!
+		* @brief Create every Entity of the snapshot, with its hierarchy and components
+		* @param created If not NULL, receives the created entities, in snapshot order
+		*/
+		bool instantiate(std::vector<Entity*>* created = NULL) const;
+
+	private:
+		system::MappedFile m_file;
+		const SnapshotHeader* m_header;
+	};
+}
+
+#endif
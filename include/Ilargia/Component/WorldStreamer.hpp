@@ -0,0 +1,175 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#ifndef INCLUDE_ILARGIA_WORLDSTREAMER_HPP
+#define INCLUDE_ILARGIA_WORLDSTREAMER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/Helper/Singleton.hpp>
+#include <Muon/String.hpp>
+#include "Ilargia/Component/WorldSnapshot.hpp"
+
+namespace ilg
+{
+	//! Identify a section queued with WorldStreamer::load()
+	typedef m::u32 StreamId;
+	static const StreamId INVALID_STREAM = 0;
+
+	enum StreamState
+	{
+		STREAM_NONE,		//!< Unknown or released StreamId
+		STREAM_QUEUED,		//!< Waiting for the loader thread
+		STREAM_LOADING,		//!< Being mapped and read by the loader thread
+		STREAM_STAGED,		//!< Loaded, waiting to be merged in the world
+		STREAM_INTEGRATING,	//!< Partially merged in the world
+		STREAM_DONE,
+		STREAM_CANCELLED,
+		STREAM_FAILED,
+	};
+
+	/*!
+	* @brief Load WorldSnapshot files in the background, and merge them in slices
+	* A loader thread maps each queued file, validates it, resolves the
+	* manager of each column and reads every page in memory: this staged
+	* section is then merged in the live world by integrate(), called by
+	* the Engine once per frame, which stops as soon as the time budget
+	* is spent. Work is done in batches of STREAM_BATCH_SIZE entities or
+	* components, using the bulk EntityManager::create(),
+	* IBaseManager::loadComponents() and onComponentsAdded() functions.
+	*
+	* Entities of a section being integrated are already alive, they get
+	* their hierarchy, then their components column after column. Wait for
+	* STREAM_DONE before using them.
+	*
+	* Every function must be called from the main thread.
+	*/
+	class ILARGIA_API WorldStreamer : public m::helper::NonCopyable
+	{
+	public:
+		MUON_SINGLETON_GET(WorldStreamer);
+
+		static const m::u32 STREAM_BATCH_SIZE = 256;
+
+		//! Start the loader thread
+		void init();
+
+		//! Stop the loader thread, and forget every section
+		void term();
+
+		/*!
+		* @brief Queue a snapshot file to be loaded
+		* @param priority Higher priorities are loaded and integrated first
+		*/
+		StreamId load(const m::String& filename, m::i32 priority = 0);
+
+		/*!
+		* @brief Stop loading a section
+		* If it is being integrated, entities already created are destroyed.
+		* @return false if the section is already done, failed or unknown
+		*/
+		bool cancel(StreamId id);
+
+		void setPriority(StreamId id, m::i32 priority);
+
+		StreamState getState(StreamId id) const;
+
+		//! Return the fraction of the section merged in the world, in [0, 1]
+		m::f32 getProgress(StreamId id) const;
+
+		//! Entities of a section in STREAM_DONE state, in snapshot order, or NULL
+		const std::vector<Entity*>* getEntities(StreamId id) const;
+
+		//! Forget a section once done, cancelled or failed (its entities stay alive)
+		bool release(StreamId id);
+
+		//! Maximum time spent by integrate() each frame, in milliseconds
+		void setTimeBudget(m::f32 milliseconds);
+		m::f32 getTimeBudget() const;
+
+		//! Merge staged sections in the world, until the time budget is spent
+		void integrate();
+
+	private:
+		enum IntegrationStep
+		{
+			STEP_ENTITIES,
+			STEP_HIERARCHY,
+			STEP_COMPONENTS,
+		};
+
+		struct Section
+		{
+			StreamId id;
+			m::String filename;
+			m::i32 priority;
+			StreamState state;
+			std::atomic<bool> cancelled;
+
+			WorldSnapshot snapshot;
+			std::vector<manager::IBaseManager*> managers;	// Per column, NULL if skipped
+
+			IntegrationStep step;
+			m::u32 column;
+			m::u32 cursor;
+			m::u32 done;
+			m::u32 total;
+			std::vector<Entity*> entities;
+			// Scratch buffers of the current component batch
+			std::vector<Entity*> targets;
+			std::vector<EntityId> owners;
+			std::vector<Component> components;
+		};
+		typedef std::vector<Section*> SectionList;
+
+		WorldStreamer();
+		~WorldStreamer();
+
+		Section* _find(StreamId id) const;
+		Section* _nextToLoad() const;
+		Section* _nextToIntegrate() const;
+		void _loaderLoop();
+		bool _stage(Section* section);
+		bool _integrateBatch(Section* section);
+		void _rollback(Section* section);
+
+		SectionList* m_sections;
+		std::thread* m_loader;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_running;
+		StreamId m_nextId;
+		m::f32 m_timeBudget;
+	};
+}
+
+#endif
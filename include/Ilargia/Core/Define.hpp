@@ -54,4 +54,31 @@
 #	endif
 #endif
 
+//		--------------------------
+//				CONFIG
+//		--------------------------
+// Maximum number of registered component types, sets the width of
+// ComponentMask. Must be a multiple of 64, and at most 256.
+#ifndef ILARGIA_MAX_COMPONENT_TYPES
+#	define ILARGIA_MAX_COMPONENT_TYPES 64
+#endif
+
+// Number of Component handles an Entity holds without allocating: past
+// that many components, its handles move to a heap array.
+#ifndef ILARGIA_ENTITY_INLINE_COMPONENTS
+#	define ILARGIA_ENTITY_INLINE_COMPONENTS 6
+#endif
+
+// SIMD kernels (see TransformBatch.hpp): SSE2 is used when the target
+// has it, AVX2 is compiled in too but only used if the CPU supports it.
+// Define ILARGIA_NO_SIMD to only build the scalar code.
+#if !defined(ILARGIA_NO_SIMD)
+#	if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define ILARGIA_SIMD_SSE
+#		if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#			define ILARGIA_SIMD_AVX2
+#		endif
+#	endif
+#endif
+
 #endif //INCLUDE_ILARGIA_DEFINE_HPP
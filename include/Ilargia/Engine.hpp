@@ -113,6 +113,11 @@ namespace ilg
 	*/
 #define ILARGIA_LIBRARY_RETURN_FAILED(error_str)		{return -1;};
 
+	namespace manager
+	{
+		class ManagerScheduler;
+	}
+
 	//! Engine functions
 	class ILARGIA_API Engine : public m::helper::NonCopyable
 	{
@@ -148,6 +153,12 @@ namespace ilg
 		static bool isRunning();
 		static bool isPaused();
 
+		/*!
+		* @brief Log the memory usage of every component manager storage
+		* Also logged every frame if "Storage" / "LogStats" is true in config.json.
+		*/
+		static void logMemoryStats();
+
 	private:
 		Engine();
 
@@ -159,9 +170,13 @@ namespace ilg
 		bool _loadConfig();
 		void _registerCoreClass();
 		void _registerCoreComponentManager();
+		void _checkMemoryBudgets();
 
 		m::system::Time m_clock;
 		m::system::Log m_log;
+		manager::ManagerScheduler* m_scheduler;
+		m::i32 m_jobWorkers;
+		bool m_logMemoryStats;
 		bool m_paused;
 		bool m_running;
 
@@ -0,0 +1,75 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_COMPONENTTYPEINDEX_HPP
+#define INCLUDE_ILARGIA_COMPONENTTYPEINDEX_HPP
+
+#include <atomic>
+#include <Muon/Meta/MetaDatabase.hpp>
+#include <Muon/String.hpp>
+#include "Ilargia/Core/Define.hpp"
+
+namespace ilg
+{
+	namespace manager
+	{
+		class IBaseManager;
+
+		static const m::u32 INVALID_TYPE_INDEX = 0xFFFFFFFF;
+
+		//! Runtime information of a registered component type, see ManagerFactory::getComponentTypeInfo()
+		struct ComponentTypeInfo
+		{
+			m::u64 id;
+			m::String name;
+			IBaseManager* manager;
+		};
+
+		//! Return the dense index given to a component type when its manager was registered, INVALID_TYPE_INDEX if none
+		ILARGIA_API m::u32 findComponentTypeIndex(m::u64 componentType);
+
+		/*!
+		* @brief Return the dense index of T, looked up once then cached
+		* Indices never change once assigned: only the first call (after
+		* the registration of the manager of T) goes through the hash table.
+		*/
+		template<typename T>
+		MUON_INLINE m::u32 getComponentTypeIndex()
+		{
+			static std::atomic<m::u32> s_index(INVALID_TYPE_INDEX);
+			m::u32 index = s_index.load(std::memory_order_relaxed);
+			if (index == INVALID_TYPE_INDEX)
+			{
+				index = findComponentTypeIndex(MUON_TRAITS_ID(T));
+				s_index.store(index, std::memory_order_relaxed);
+			}
+			return index;
+		}
+	}
+}
+
+#endif
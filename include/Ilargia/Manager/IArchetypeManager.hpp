@@ -0,0 +1,221 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_IARCHETYPEMANAGER_HPP
+#define INCLUDE_ILARGIA_IARCHETYPEMANAGER_HPP
+
+#include "Ilargia/Manager/IComponentManager.hpp"
+#include "Ilargia/Component/ArchetypeStorage.hpp"
+
+namespace ilg
+{
+	namespace manager
+	{
+		/*!
+		* @brief Component manager storing its components in the shared ArchetypeStorage
+		* This is the storage policy to choose (with ILARGIA_COMPONENT_MANAGER_DECL_ARCHETYPE)
+		* for components mostly processed together with other ones: the components
+		* of an Entity live in the same chunk, whatever their manager.
+		* Components are stored by owner, so a handle refers to its Entity slot,
+		* and is only valid as long as the Entity. There is no BasicComponentStorage:
+		* View and getComponentStorage() don't see these components, use forEach().
+		* They can't be part of a WorldSnapshot or a Prefab either.
+		*/
+		template<typename ComponentType>
+		class IArchetypeManager : public IBaseManager
+		{
+		public:
+			IArchetypeManager(m::i32 updateOrder)
+				: IBaseManager(MUON_TRAITS_NAME(ComponentType), MUON_TRAITS_ID(ComponentType), updateOrder)
+			{
+			}
+
+			virtual ~IArchetypeManager()
+			{
+			}
+
+			virtual void onInit() = 0;
+			virtual void onUpdate(m::f32 deltaTime) = 0;
+			virtual void onTerm() = 0;
+
+			virtual void onKeyCallback(void* windowHandle, int key, int scancode, int action, int modifier)
+			{
+			}
+
+			virtual void onComponentAdded(Entity* entity, Component& component)
+			{
+			}
+
+			virtual void onComponentRemoved(Entity* entity, Component& component)
+			{
+			}
+
+			virtual Component createComponent()
+			{
+				MUON_ASSERT(false, "%s components are stored by owner, use Entity::addComponent()!", MUON_TRAITS_NAME(ComponentType));
+				return Component();
+			}
+
+			virtual Component createOwnedComponent(EntityId owner)
+			{
+				ArchetypeStorage& storage = getArchetypeStorage();
+				if (!storage.hasEntity(owner))
+				{
+					storage.addEntity(owner);
+				}
+				storage.addComponent<ComponentType>(owner);
+				return setupComponent((m::i32)getEntityIndex(owner), getEntityGeneration(owner));
+			}
+
+			virtual void destroyComponent(Component& component)
+			{
+				getArchetypeStorage().template removeComponent<ComponentType>(_getOwner(component));
+			}
+
+			virtual void* getComponent(m::i32 index)
+			{
+				Entity* entity = EntityManager::getInstance().getFromSlot((m::u32)index);
+				return (entity != NULL ? getArchetypeStorage().template getComponent<ComponentType>(entity->getId()) : NULL);
+			}
+
+			//! Linear in the number of chunks holding ComponentType
+			virtual Component getComponent(void* object)
+			{
+				const ArchetypeStorage& storage = getArchetypeStorage();
+				for (m::u32 a = 0; a < storage.getArchetypeCount(); ++a)
+				{
+					const Archetype* archetype = storage.getArchetype(a);
+					if (!archetype->hasType(MUON_TRAITS_ID(ComponentType)))
+					{
+						continue;
+					}
+					for (m::u32 c = 0; c < archetype->getChunkCount(); ++c)
+					{
+						const ArchetypeChunk& chunk = archetype->getChunk(c);
+						ComponentType* column = archetype->getColumn<ComponentType>(chunk);
+						if ((ComponentType*)object >= column && (ComponentType*)object < column + chunk.count)
+						{
+							const EntityId owner = archetype->getEntities(chunk)[(ComponentType*)object - column];
+							return setupComponent((m::i32)getEntityIndex(owner), getEntityGeneration(owner));
+						}
+					}
+				}
+				return Component();
+			}
+
+			virtual bool isComponentAlive(const Component& component) const
+			{
+				return component.getTypeIndex() == getComponentTypeIndex()
+					&& getArchetypeStorage().template getComponent<ComponentType>(_getOwner(component)) != NULL;
+			}
+
+			virtual void setComponentOwner(const Component& component, EntityId owner)
+			{
+				MUON_ASSERT(_getOwner(component) == owner, "%s components can't change owner!", MUON_TRAITS_NAME(ComponentType));
+			}
+
+			//! Chunks are allocated and freed as archetypes grow and shrink
+			virtual void reserveComponents(m::i32 count)
+			{
+			}
+
+			virtual void shrinkComponents()
+			{
+			}
+
+			//! Only the ComponentType column of the chunks is accounted for
+			virtual StorageStats getStats() const
+			{
+				StorageStats stats = {};
+				const ArchetypeStorage& storage = getArchetypeStorage();
+				for (m::u32 a = 0; a < storage.getArchetypeCount(); ++a)
+				{
+					const Archetype* archetype = storage.getArchetype(a);
+					if (archetype->hasType(MUON_TRAITS_ID(ComponentType)))
+					{
+						stats.size += (m::i32)archetype->getEntityCount();
+						stats.capacity += (m::i32)(archetype->getChunkCount() * archetype->getChunkCapacity());
+					}
+				}
+				stats.peakSize = stats.size;
+				stats.bytes = (m::u64)stats.capacity * sizeof(ComponentType);
+				stats.usedBytes = (m::u64)stats.size * sizeof(ComponentType);
+				stats.fragmentation = (stats.bytes > 0 ? 1.f - (m::f32)stats.usedBytes / (m::f32)stats.bytes : 0.f);
+				return stats;
+			}
+
+			virtual m::u32 getComponentSize() const
+			{
+				return sizeof(ComponentType);
+			}
+
+			virtual bool isComponentSerializable() const
+			{
+				return false;
+			}
+
+			virtual void copyComponents(void* dst, EntityId* owners) const
+			{
+			}
+
+			virtual void loadComponents(const void* src, m::i32 count, const EntityId* owners, Component* out)
+			{
+			}
+
+			virtual void cloneComponents(const void* src, m::i32 count, m::i32 copies, const EntityId* owners, Component* out)
+			{
+			}
+
+			virtual void onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count) = 0;
+		protected:
+			MUON_INLINE ArchetypeStorage& getArchetypeStorage() const
+			{
+				return EntityManager::getInstance().getArchetypeStorage();
+			}
+
+			/*!
+			* @brief Call func on every chunk holding ComponentType and all the Others types
+			* See ArchetypeStorage::forEach(): func(m::u32 count, EntityId* ids, ComponentType*, Others*...)
+			*/
+			template<typename ...Others, typename Func>
+			void forEach(Func func) const
+			{
+				getArchetypeStorage().template forEach<ComponentType, Others...>(func);
+			}
+
+		private:
+			MUON_INLINE static EntityId _getOwner(const Component& component)
+			{
+				return makeEntityId((m::u32)component.getInstanceIndex(), component.getInstanceGeneration());
+			}
+		};
+	}
+}
+
+//! Declare the manager of a Component stored in the shared ArchetypeStorage, see IArchetypeManager
+#define ILARGIA_COMPONENT_MANAGER_DECL_ARCHETYPE(Component) class ILARGIA_API ILARGIA_COMPONENT_MANAGER_NAME(Component) : public ::ilg::manager::IArchetypeManager<Component>
+#endif
@@ -28,10 +28,14 @@
 #ifndef INCLUDE_ILARGIA_IBASEMANAGER_HPP
 #define INCLUDE_ILARGIA_IBASEMANAGER_HPP
 
+#include <vector>
 #include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/System/Assert.hpp>
 #include <Muon/System/Log.hpp>
 #include "Ilargia/Component/Entity.hpp"
+#include "Ilargia/Component/EntityEvent.hpp"
 #include "Ilargia/Component/Component.hpp"
+#include "Ilargia/Component/ComponentStorage.hpp"
 
 namespace ilg
 {
@@ -48,8 +52,23 @@ namespace ilg
 
 			const m::String&	getManagerName() const;
 			m::u64			getComponentType() const;
+			m::u32			getComponentTypeIndex() const;
 			m::i32			getUpdateOrder() const;
 
+			/*!
+			* @brief Component types read or written by onUpdate()
+			* Managers declaring their accesses may be updated in parallel with
+			* the ones they don't conflict with (a write conflicts with any other
+			* access to the same type). A manager declaring nothing is updated
+			* alone, on the main thread.
+			*/
+			const std::vector<m::u64>& getReadAccess() const;
+			const std::vector<m::u64>& getWriteAccess() const;
+			bool hasDeclaredAccess() const;
+
+			//! Mask of the EntityEventType the manager subscribed to
+			m::u32 getEventSubscriptions() const;
+
 			virtual void onInit() = 0;
 			virtual void onUpdate(m::f32 deltaTime) = 0;
 			virtual void onTerm() = 0;
@@ -58,18 +77,107 @@ namespace ilg
 
 			virtual void onComponentAdded(Entity* entity, Component& component) = 0;
 			virtual void onComponentRemoved(Entity* entity, Component& component) = 0;
+			/*!
+			* @brief Called once for components given to many entities at once (see Prefab)
+			* Calls onComponentAdded() for each component by default.
+			*/
+			virtual void onComponentsAdded(Entity* const* entities, Component* components, m::u32 count);
 
 			virtual Component createComponent() = 0;
+			/*!
+			* @brief Create a Component already owned by an Entity, used by Entity::addComponent()
+			* Calls createComponent() then setComponentOwner() by default. Managers
+			* storing components by owner (see IArchetypeManager) override it.
+			*/
+			virtual Component createOwnedComponent(EntityId owner);
 			virtual void destroyComponent(Component& component) = 0;
 			virtual void* getComponent(m::i32 index) = 0;
 			virtual Component getComponent(void* object) = 0;
+			//! Return false if the Component handle was removed since its creation
+			virtual bool isComponentAlive(const Component& component) const = 0;
+			virtual void setComponentOwner(const Component& component, EntityId owner) = 0;
+
+			//! Pre-size the component storage for count components (see "Storage" in config.json)
+			virtual void reserveComponents(m::i32 count) = 0;
+			//! Release the memory of the component storage not used anymore
+			virtual void shrinkComponents() = 0;
+
+			//! Memory usage of the component storage, zeroed for managers without one
+			virtual StorageStats getStats() const = 0;
+
+			/*!
+			* @brief Type-erased bulk access to the components, used by WorldSnapshot
+			* Components can only be copied byte per byte (to a file, for instance)
+			* when isComponentSerializable() is true.
+			*/
+			virtual m::u32 getComponentSize() const = 0;
+			virtual bool isComponentSerializable() const = 0;
+			//! Copy every component in dense order to dst, and their owner to owners (both hold getStats().size elements)
+			virtual void copyComponents(void* dst, EntityId* owners) const = 0;
+			//! Add count components copied from src, owned by owners (NULL for none), and write their handles in out
+			virtual void loadComponents(const void* src, m::i32 count, const EntityId* owners, Component* out) = 0;
+			//! Add copies times the count components of src, owned by owners (count * copies), and write their handles in out
+			virtual void cloneComponents(const void* src, m::i32 count, m::i32 copies, const EntityId* owners, Component* out) = 0;
+
+			/*!
+			* @brief Maximum memory the component storage should use, 0 for none
+			* Exceeding it is not an error: the Engine logs a warning, see Engine::logMemoryStats().
+			*/
+			void setMemoryBudget(m::u64 bytes);
+			m::u64 getMemoryBudget() const;
+			bool isOverBudget() const;
+			//! Return true if the storage was resized since the last call, and is now over budget
+			bool checkMemoryBudget();
 
-			virtual void onEntityHierarchyChanged(Entity* entity, Entity* previousParent, Entity* newParent) = 0;
+			/*!
+			* @brief Direct access to the storage of a component manager
+			* No virtual call is involved, so this can be fetched once and
+			* used in tight loops (see View).
+			* @return NULL if the manager does not store T Component
+			*/
+			template<typename T>
+			BasicComponentStorage<T>* getComponentStorage() const
+			{
+				MUON_ASSERT(m_componentType == MUON_TRAITS_ID(T)
+							, "Manager \"%s\" does not store %s Component!"
+							, m_managerName.cStr(), MUON_TRAITS_NAME(T));
+				return (m_componentType == MUON_TRAITS_ID(T) ? (BasicComponentStorage<T>*)m_componentStorage : NULL);
+			}
+
+			/*!
+			* @brief Receive every hierarchy change of the frame, in the order they happened
+			* Only called if the manager subscribed to ENTITY_EVENT_HIERARCHY.
+			*/
+			virtual void onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count) = 0;
 		protected:
+			template<typename T>
+			void declareRead()
+			{
+				declareRead(MUON_TRAITS_ID(T));
+			}
+
+			template<typename T>
+			void declareWrite()
+			{
+				declareWrite(MUON_TRAITS_ID(T));
+			}
+
+			void declareRead(m::u64 componentType);
+			void declareWrite(m::u64 componentType);
+
+			//! Receive the given EntityEventType (combined as a mask), see EntityManager::flushEvents()
+			void subscribe(m::u32 events);
+
 			template<typename T>
 			Component setupComponent(m::i32 instance)
 			{
-				return Component(MUON_META(T)->id(), instance, MUON_META(T)->name());
+				return Component(m_typeIndex, instance, getComponentStorage<T>()->getGeneration(instance));
+			}
+
+			//! Handle of the manager type, for managers without a BasicComponentStorage
+			MUON_INLINE Component setupComponent(m::i32 instance, m::u32 generation) const
+			{
+				return Component(m_typeIndex, instance, generation);
 			}
 
 			m::system::Log& getLog()
@@ -82,12 +190,23 @@ namespace ilg
 				return m_log(level);
 			}
 
+			//! Set by IComponentManager, so getComponentStorage() can return it
+			void* m_componentStorage;
+
 		private:
 			friend class ManagerFactory;
 			m::system::Log m_log;
 			m::String	m_managerName;
+			m::String	m_typeName;
 			m::u64		m_componentType;
+			m::u32		m_typeIndex;
 			m::i32		m_updateOrder;
+			bool		m_declaredAccess;
+			m::u32		m_eventSubscriptions;
+			m::u64		m_memoryBudget;
+			m::u32		m_checkedReallocCount;
+			std::vector<m::u64> m_readAccess;
+			std::vector<m::u64> m_writeAccess;
 		};
 	}
 }
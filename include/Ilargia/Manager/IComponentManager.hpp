@@ -28,22 +28,46 @@
 #ifndef INCLUDE_ILARGIA_ICOMPONENTMANAGER_HPP
 #define INCLUDE_ILARGIA_ICOMPONENTMANAGER_HPP
 
+#include <type_traits>
 #include "Ilargia/Manager/IBaseManager.hpp"
+#include "Ilargia/System/ParallelFor.hpp"
 
 namespace ilg
 {
 	namespace manager
 	{
+		namespace detail
+		{
+			//! Reset the Component handle base of a component copied byte per byte
+			template<typename T, bool IsComponent = std::is_base_of<Component, T>::value>
+			struct ComponentHandleReset
+			{
+				static MUON_INLINE void reset(T& component)
+				{
+					static_cast<Component&>(component) = Component();
+				}
+			};
+
+			template<typename T>
+			struct ComponentHandleReset<T, false>
+			{
+				static MUON_INLINE void reset(T&)
+				{
+				}
+			};
+		}
+
 		static const m::u32 ComponentManagerChunkSize = 64;
-		template<typename ComponentType, m::u32 ChunkSize = ComponentManagerChunkSize>
+		template<typename ComponentType, m::u32 ChunkSize = ComponentManagerChunkSize, StorageGrowth Growth = STORAGE_GROWTH_GEOMETRIC>
 		class IComponentManager : public IBaseManager
 		{
-			typedef ComponentStorage<ComponentType, ChunkSize> ComponentList;
+			typedef ComponentStorage<ComponentType, ChunkSize, Growth> ComponentList;
 		public:
 			IComponentManager(m::i32 updateOrder)
 				: IBaseManager(MUON_TRAITS_NAME(ComponentType), MUON_TRAITS_ID(ComponentType), updateOrder)
 			{
 				m_components = MUON_NEW(ComponentList);
+				m_componentStorage = static_cast<BasicComponentStorage<ComponentType>*>(m_components);
 			}
 
 			virtual ~IComponentManager()
@@ -71,9 +95,126 @@ namespace ilg
 			virtual void* getComponent(m::i32 index) = 0;
 			virtual Component getComponent(void* object) = 0;
 
-			virtual void onEntityHierarchyChanged(Entity* entity, Entity* previousParent, Entity* newParent) = 0;
+			virtual bool isComponentAlive(const Component& component) const
+			{
+				const m::i32 index = component.getInstanceIndex();
+				return component.getTypeIndex() == getComponentTypeIndex()
+					&& m_components->has(index)
+					&& m_components->getGeneration(index) == component.getInstanceGeneration();
+			}
+
+			virtual void setComponentOwner(const Component& component, EntityId owner)
+			{
+				m_components->setOwner(component.getInstanceIndex(), owner);
+			}
+
+			virtual void reserveComponents(m::i32 count)
+			{
+				m_components->reserve(count);
+			}
+
+			virtual void shrinkComponents()
+			{
+				m_components->shrinkToFit();
+			}
+
+			virtual StorageStats getStats() const
+			{
+				return m_components->getStats();
+			}
+
+			virtual m::u32 getComponentSize() const
+			{
+				return sizeof(ComponentType);
+			}
+
+			virtual bool isComponentSerializable() const
+			{
+				return std::is_trivially_copyable<ComponentType>::value;
+			}
+
+			virtual void copyComponents(void* dst, EntityId* owners) const
+			{
+				// Dense elements are contiguous within a page
+				ComponentType* out = (ComponentType*)dst;
+				const m::i32 size = m_components->size();
+				const m::i32 page = m_components->pageSize();
+				for (m::i32 pos = 0; pos < size;)
+				{
+					const m::i32 run = std::min(page - pos % page, size - pos);
+					memcpy((void*)out, (const void*)&m_components->getDense(pos), sizeof(ComponentType) * run);
+					out += run;
+					pos += run;
+				}
+				memcpy(owners, m_components->getOwners(), sizeof(EntityId) * size);
+			}
+
+			virtual void loadComponents(const void* src, m::i32 count, const EntityId* owners, Component* out)
+			{
+				_appendLoadedComponents((const ComponentType*)src, count, owners, out);
+			}
+
+			virtual void cloneComponents(const void* src, m::i32 count, m::i32 copies, const EntityId* owners, Component* out)
+			{
+				// One reservation for every copy, then one bulk append per copy
+				m_components->reserve(m_components->size() + count * copies);
+				for (m::i32 copy = 0; copy < copies; ++copy)
+				{
+					_appendLoadedComponents((const ComponentType*)src, count, owners + copy * count, out + copy * count);
+				}
+			}
+
+			virtual void onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count) = 0;
 		protected:
+			/*!
+			* @brief Called on each component copied byte per byte, see loadComponents() and cloneComponents()
+			* Its Component handle base is already reset. Override it to reset the
+			* fields only meaningful in the run that saved them (caches, indices...).
+			*/
+			virtual void onComponentLoaded(ComponentType& component)
+			{
+			}
+
+			//! Call func(ComponentType&) on every component in parallel, see system::parallelForEach()
+			template<typename Func>
+			void parallelForEach(m::i32 grainSize, const Func& func)
+			{
+				system::parallelForEach(*static_cast<BasicComponentStorage<ComponentType>*>(m_components), grainSize, func);
+			}
+
+			//! Call func(ComponentType&) on every component changed since version, in parallel, see system::parallelForEachChanged()
+			template<typename Func>
+			void parallelForEachChanged(m::u32 version, m::i32 grainSize, const Func& func)
+			{
+				system::parallelForEachChanged(*static_cast<BasicComponentStorage<ComponentType>*>(m_components), version, grainSize, func);
+			}
+
+			//! Reduce every component in parallel with a deterministic result, see system::parallelReduceEach()
+			template<typename R, typename Map, typename Combine>
+			R parallelReduce(m::i32 grainSize, const R& identity, const Map& map, const Combine& combine)
+			{
+				return system::parallelReduceEach(*static_cast<BasicComponentStorage<ComponentType>*>(m_components), grainSize, identity, map, combine);
+			}
+
 			ComponentList* m_components;
+
+		private:
+			void _resetLoadedComponent(ComponentType& component)
+			{
+				detail::ComponentHandleReset<ComponentType>::reset(component);
+				onComponentLoaded(component);
+			}
+
+			//! Copy count components at the end of the storage, then fix their handle base
+			void _appendLoadedComponents(const ComponentType* in, m::i32 count, const EntityId* owners, Component* out)
+			{
+				const m::i32 first = m_components->append(in, count, owners);
+				for (m::i32 i = 0; i < count; ++i)
+				{
+					_resetLoadedComponent(m_components->getDense(first + i));
+					out[i] = setupComponent<ComponentType>(m_components->getIndex(first + i));
+				}
+			}
 		};
 	}
 }
@@ -82,6 +223,12 @@ namespace ilg
 #define ILARGIA_COMPONENT_HAS_STATIC_MANAGER(Type, Name) static ILARGIA_COMPONENT_MANAGER_NAME(Type)* Name
 #define ILARGIA_COMPONENT_FRIEND_MANAGER(Type) friend class ILARGIA_COMPONENT_MANAGER_NAME(Type)
 
-#define ILARGIA_COMPONENT_MANAGER_DECL_SIZE(Component, ChunkSize) class ILARGIA_API ILARGIA_COMPONENT_MANAGER_NAME(Component) : public ::ilg::manager::IComponentManager<Component, ChunkSize>
+/*!
+* @brief Declare the manager of a Component with a specific storage
+* Parameters following the Component are forwarded to IComponentManager:
+* the chunk size, and optionally the StorageGrowth policy.
+* Example: ILARGIA_COMPONENT_MANAGER_DECL_SIZE(Transform, 256, ::ilg::STORAGE_GROWTH_PAGED)
+*/
+#define ILARGIA_COMPONENT_MANAGER_DECL_SIZE(Component, ...) class ILARGIA_API ILARGIA_COMPONENT_MANAGER_NAME(Component) : public ::ilg::manager::IComponentManager<Component, __VA_ARGS__>
 #define ILARGIA_COMPONENT_MANAGER_DECL(Component) ILARGIA_COMPONENT_MANAGER_DECL_SIZE(Component, ilg::manager::ComponentManagerChunkSize)
 #endif
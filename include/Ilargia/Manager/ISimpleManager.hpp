@@ -54,7 +54,17 @@ namespace ilg
 			virtual void destroyComponent(Component& component);
 			virtual void* getComponent(m::i32 index);
 			virtual Component getComponent(void* object);
-			virtual void onEntityHierarchyChanged(Entity* entity, Entity* previousParent, Entity* newParent);
+			virtual bool isComponentAlive(const Component& component) const;
+			virtual void setComponentOwner(const Component& component, EntityId owner);
+			virtual void reserveComponents(m::i32 count);
+			virtual void shrinkComponents();
+			virtual StorageStats getStats() const;
+			virtual m::u32 getComponentSize() const;
+			virtual bool isComponentSerializable() const;
+			virtual void copyComponents(void* dst, EntityId* owners) const;
+			virtual void loadComponents(const void* src, m::i32 count, const EntityId* owners, Component* out);
+			virtual void cloneComponents(const void* src, m::i32 count, m::i32 copies, const EntityId* owners, Component* out);
+			virtual void onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count);
 		};
 	}
 }
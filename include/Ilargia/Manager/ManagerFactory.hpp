@@ -28,13 +28,24 @@
 #ifndef INCLUDE_ILARGIA_MANAGERFACTORY_HPP
 #define INCLUDE_ILARGIA_MANAGERFACTORY_HPP
 
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <Muon/Helper/Singleton.hpp>
 #include "Ilargia/Manager/IBaseManager.hpp"
+#include "Ilargia/Manager/ComponentTypeIndex.hpp"
 
 namespace ilg
 {
 	namespace manager
 	{
+		/*!
+		* @brief Register managers and find them back
+		* Each component manager gets a small dense type index at registration:
+		* finding the manager of a type index is a single array access, and
+		* getComponentManager<T>() caches the index of T on first use.
+		* Lookups by type id or by name go through hash tables.
+		*/
 		class ILARGIA_API ManagerFactory : public m::helper::NonCopyable
 		{
 		public:
@@ -45,6 +56,21 @@ namespace ilg
 			IBaseManager* getComponentManager(m::u64 componentType);
 			IBaseManager* getComponentManager(const m::String& name);
 
+			template<typename T>
+			MUON_INLINE IBaseManager* getComponentManager()
+			{
+				return getComponentManagerFromTypeIndex(manager::getComponentTypeIndex<T>());
+			}
+
+			MUON_INLINE IBaseManager* getComponentManagerFromTypeIndex(m::u32 typeIndex) const
+			{
+				return (typeIndex < m_types->size() ? (*m_types)[typeIndex].manager : NULL);
+			}
+
+			m::u32 getComponentTypeIndex(m::u64 componentType) const;
+			m::u32 getComponentTypeCount() const;
+			const ComponentTypeInfo& getComponentTypeInfo(m::u32 typeIndex) const;
+
 			m::u32 getComponentManagerCount() const;
 			IBaseManager* getComponentManagerFromIndex(m::u32);
 		private:
@@ -54,6 +80,10 @@ namespace ilg
 			ManagerFactory(const ManagerFactory&);
 			ManagerFactory& operator = (const ManagerFactory&);
 			virtual ~ManagerFactory();
+
+			std::vector<ComponentTypeInfo>* m_types;
+			std::unordered_map<m::u64, m::u32>* m_typeIndices;
+			std::unordered_map<std::string, IBaseManager*>* m_managerNames;
 		};
 
 #define ILARGIA_GET_COMPONENT_MANAGER_FROM_TYPE(ManagerType, ComponentType) ((ManagerType*)::ilg::manager::ManagerFactory::getInstance().getComponentManager(ComponentType))
@@ -0,0 +1,132 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_JOBSYSTEM_HPP
+#define INCLUDE_ILARGIA_JOBSYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/Helper/Singleton.hpp>
+#include "Ilargia/Core/Define.hpp"
+
+namespace ilg
+{
+	namespace system
+	{
+		//! Number of submitted jobs not finished yet, see JobSystem::wait()
+		typedef std::atomic<m::i32> JobCounter;
+
+		/*!
+		* @brief Work-stealing thread pool
+		* Every thread (the main one and each worker) has its own job queue:
+		* a thread pushes and pops jobs at the back of its queue, and when
+		* it is empty, steals the oldest job at the front of another one.
+		*
+		* Waiting on a JobCounter never blocks: the waiting thread executes
+		* pending jobs until the counter reaches 0. With 0 worker, every job
+		* is thus executed by the thread waiting for it.
+		*/
+		class ILARGIA_API JobSystem : public m::helper::NonCopyable
+		{
+		public:
+			MUON_SINGLETON_GET(JobSystem);
+
+			typedef std::function<void()> JobFunc;
+
+			/*!
+			* @brief Start the worker threads
+			* @param workerCount Number of threads created in addition to the main one
+			*/
+			void init(m::u32 workerCount);
+
+			//! Execute remaining jobs, then stop and join the worker threads
+			void term();
+
+			m::u32 getWorkerCount() const;
+
+			/*!
+			* @brief Return 0 on the main thread, [1..getWorkerCount()] on workers
+			* The main thread is the one creating the JobSystem. Other threads
+			* (a WorldStreamer loader, user threads) have no per-thread state:
+			* calling this, or submitting and waiting on jobs, is an error there.
+			*/
+			static m::u32 getThreadIndex();
+
+			/*!
+			* @brief Queue a job on the calling thread queue
+			* @param job Function to execute
+			* @param counter If not NULL, incremented now and decremented once the job is done
+			*/
+			void submit(const JobFunc& job, JobCounter* counter = NULL);
+
+			//! Execute pending jobs until the counter reaches 0
+			void wait(JobCounter* counter);
+
+			//! Execute one pending job, return false if there was none
+			bool runPendingJob();
+
+		private:
+			struct Job
+			{
+				JobFunc func;
+				JobCounter* counter;
+			};
+
+			struct WorkQueue
+			{
+				std::mutex mutex;
+				std::deque<Job> jobs;
+			};
+			// Mutexes can't be moved: the list is allocated again rather than resized
+			typedef std::vector<WorkQueue> WorkQueueList;
+
+			JobSystem();
+			~JobSystem();
+
+			bool _pop(m::u32 thread, Job& job);
+			bool _steal(m::u32 thief, Job& job);
+			void _execute(Job& job);
+			void _workerLoop(m::u32 index);
+
+			std::vector<std::thread>* m_workers;
+			WorkQueueList* m_queues;
+			m::u32 m_queueCount;
+			std::atomic<bool> m_running;
+			std::atomic<m::i32> m_pendingJobs;
+			std::mutex m_sleepMutex;
+			std::condition_variable m_sleepCondition;
+		};
+	}
+}
+
+#endif
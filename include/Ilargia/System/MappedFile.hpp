@@ -0,0 +1,73 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_MAPPEDFILE_HPP
+#define INCLUDE_ILARGIA_MAPPEDFILE_HPP
+
+#include <Muon/Helper/NonCopyable.hpp>
+#include <Muon/String.hpp>
+#include "Ilargia/Core/Define.hpp"
+
+namespace ilg
+{
+	namespace system
+	{
+		/*!
+		* @brief Read-only memory mapping of a whole file
+		* Pages are loaded by the OS on first access: opening is immediate
+		* whatever the file size, and untouched parts are never read.
+		*/
+		class ILARGIA_API MappedFile : public m::helper::NonCopyable
+		{
+		public:
+			MappedFile();
+			~MappedFile();
+
+			bool open(const m::String& filename);
+			void close();
+
+			bool isOpen() const;
+			const m::u8* data() const;
+			m::u64 size() const;
+
+			/*!
+			* @brief Load every page of the file now
+			* Reading the mapping afterwards won't stall on disk: call it from
+			* a background thread before handing the data to the main one.
+			*/
+			void prefetch() const;
+
+		private:
+			const m::u8* m_data;
+			m::u64 m_size;
+			void* m_file;
+			void* m_mapping;
+		};
+	}
+}
+
+#endif
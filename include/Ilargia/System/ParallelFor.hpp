@@ -0,0 +1,217 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_PARALLELFOR_HPP
+#define INCLUDE_ILARGIA_PARALLELFOR_HPP
+
+#include <algorithm>
+#include <vector>
+#include "Ilargia/Component/ComponentStorage.hpp"
+#include "Ilargia/System/JobSystem.hpp"
+
+namespace ilg
+{
+	namespace system
+	{
+		static const m::i32 CACHE_LINE_SIZE = 64;
+
+		/*!
+		* @brief Split [0, count) in ranges of grainSize and call func(begin, end) on each of them
+		* Ranges are dispatched to the JobSystem workers, the calling thread
+		* executes the first one then helps until every range is done.
+		*/
+		template<typename Func>
+		void parallelFor(m::i32 count, m::i32 grainSize, const Func& func)
+		{
+			if (count <= 0)
+			{
+				return;
+			}
+			grainSize = std::max<m::i32>(grainSize, 1);
+
+			JobSystem& jobs = JobSystem::getInstance();
+			if (count <= grainSize || jobs.getWorkerCount() == 0)
+			{
+				func(0, count);
+				return;
+			}
+
+			JobCounter counter(0);
+			for (m::i32 begin = grainSize; begin < count; begin += grainSize)
+			{
+				m::i32 end = std::min(begin + grainSize, count);
+				jobs.submit([&func, begin, end]() { func(begin, end); }, &counter);
+			}
+			func(0, grainSize);
+			jobs.wait(&counter);
+		}
+
+		/*!
+		* @brief Reduce [0, count) in parallel, with a result independent of the worker count
+		* Each range of grainSize is reduced by map(begin, end), then the partial
+		* results are combined in range order: combine(combine(identity, r0), r1)...
+		* For a given count and grainSize, floating point results are thus
+		* always the same, whatever the number of threads.
+		*/
+		template<typename R, typename Map, typename Combine>
+		R parallelReduce(m::i32 count, m::i32 grainSize, const R& identity, const Map& map, const Combine& combine)
+		{
+			if (count <= 0)
+			{
+				return identity;
+			}
+			grainSize = std::max<m::i32>(grainSize, 1);
+
+			std::vector<R> partials((count + grainSize - 1) / grainSize, identity);
+			parallelFor(count, grainSize, [&partials, &map, grainSize](m::i32 begin, m::i32 end)
+			{
+				// A range may hold several partitions when executed inline
+				for (; begin < end; begin += grainSize)
+				{
+					partials[begin / grainSize] = map(begin, std::min(begin + grainSize, end));
+				}
+			});
+
+			R result = identity;
+			for (auto it = partials.begin(); it != partials.end(); ++it)
+			{
+				result = combine(result, *it);
+			}
+			return result;
+		}
+
+		namespace detail
+		{
+			//! Round the grain so ranges hold whole cache lines, and whole pages when they span several
+			template<typename T>
+			m::i32 alignGrain(const BasicComponentStorage<T>& storage, m::i32 grainSize)
+			{
+				const m::i32 perLine = (sizeof(T) < (size_t)CACHE_LINE_SIZE ? CACHE_LINE_SIZE / (m::i32)sizeof(T) : 1);
+				grainSize = std::max<m::i32>(grainSize, 1);
+				grainSize = ((grainSize + perLine - 1) / perLine) * perLine;
+
+				const m::i32 page = storage.pageSize();
+				if (storage.growth() == STORAGE_GROWTH_PAGED && grainSize > page)
+				{
+					grainSize = ((grainSize + page - 1) / page) * page;
+				}
+				return grainSize;
+			}
+
+			//! Call func(T*, count) on each contiguous run of the dense positions [begin, end)
+			template<typename T, typename Func>
+			void forEachRun(BasicComponentStorage<T>& storage, m::i32 begin, m::i32 end, const Func& func)
+			{
+				const m::i32 page = storage.pageSize();
+				while (begin < end)
+				{
+					m::i32 runEnd = end;
+					if (storage.growth() == STORAGE_GROWTH_PAGED)
+					{
+						runEnd = std::min(end, (begin / page + 1) * page);
+					}
+					func(&storage.getDense(begin), runEnd - begin);
+					begin = runEnd;
+				}
+			}
+		}
+
+		/*!
+		* @brief Call func(T&) on every live element of the storage, in parallel
+		* @param grainSize Minimum number of elements per job, rounded to a cache line (and a page for bigger grains)
+		* func must not add or remove elements of the storage.
+		*/
+		template<typename T, typename Func>
+		void parallelForEach(BasicComponentStorage<T>& storage, m::i32 grainSize, const Func& func)
+		{
+			parallelFor(storage.size(), detail::alignGrain(storage, grainSize), [&storage, &func](m::i32 begin, m::i32 end)
+			{
+				detail::forEachRun(storage, begin, end, [&func](T* data, m::i32 count)
+				{
+					for (m::i32 i = 0; i < count; ++i)
+					{
+						func(data[i]);
+					}
+				});
+			});
+		}
+
+		/*!
+		* @brief Call func(T&) on every element changed since version, in parallel
+		* Ranges are whole change chunks: a chunk not changed since version is
+		* skipped without reading its elements, see BasicComponentStorage::changedSince().
+		*/
+		template<typename T, typename Func>
+		void parallelForEachChanged(BasicComponentStorage<T>& storage, m::u32 version, m::i32 grainSize, const Func& func)
+		{
+			const m::i32 chunkSize = BasicComponentStorage<T>::CHANGE_CHUNK_SIZE;
+			const m::i32 chunks = std::max<m::i32>((grainSize + chunkSize - 1) / chunkSize, 1);
+			parallelFor(storage.chunkCount(), chunks, [&storage, &func, version, chunkSize](m::i32 begin, m::i32 end)
+			{
+				for (m::i32 chunk = begin; chunk < end; ++chunk)
+				{
+					if (!storage.chunkChangedSince(chunk, version))
+					{
+						continue;
+					}
+					const m::i32 last = std::min((chunk + 1) * chunkSize, storage.size());
+					for (m::i32 pos = chunk * chunkSize; pos < last; ++pos)
+					{
+						if (storage.changedSince(pos, version))
+						{
+							func(storage.getDense(pos));
+						}
+					}
+				}
+			});
+		}
+
+		/*!
+		* @brief Reduce every live element of the storage in parallel, see parallelReduce()
+		* Each range starts from identity and accumulates its elements with map(R&, const T&),
+		* then the partial results are combined in range order.
+		*/
+		template<typename R, typename T, typename Map, typename Combine>
+		R parallelReduceEach(BasicComponentStorage<T>& storage, m::i32 grainSize, const R& identity, const Map& map, const Combine& combine)
+		{
+			return parallelReduce(storage.size(), detail::alignGrain(storage, grainSize), identity, [&storage, &map, &identity](m::i32 begin, m::i32 end)
+			{
+				R partial = identity;
+				detail::forEachRun(storage, begin, end, [&partial, &map](T* data, m::i32 count)
+				{
+					for (m::i32 i = 0; i < count; ++i)
+					{
+						map(partial, data[i]);
+					}
+				});
+				return partial;
+			}, combine);
+		}
+	}
+}
+
+#endif
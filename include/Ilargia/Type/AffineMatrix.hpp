@@ -0,0 +1,115 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#ifndef INCLUDE_ILARGIA_AFFINEMATRIX_HPP
+#define INCLUDE_ILARGIA_AFFINEMATRIX_HPP
+
+#include "Ilargia/Type/Matrix.hpp"
+
+namespace ilg
+{
+	/*!
+	* @brief A 3x4 m::f32 affine Matrix, the last row of (0, 0, 0, 1) being implicit
+	*
+	* Rows are the columns of the equivalent Matrix: each one gives a coordinate
+	* of a transformed point, the w attribute being the translation.
+	* <table>
+	*	<tr><td></td><td>.x</td><td>.y</td><td>.z</td><td>.w</td></tr>
+	*	<tr><td>x</td><td>0</td><td>1</td><td>2</td><td>3</td></tr>
+	*	<tr><td>y</td><td>4</td><td>5</td><td>6</td><td>7</td></tr>
+	*	<tr><td>z</td><td>8</td><td>9</td><td>10</td><td>11</td></tr>
+	* </table>
+	*
+	* AffineMatrix.x.y = Matrix.y.x , AffineMatrix.z.w = Matrix.w.z ...
+	* 12 floats instead of 16, and 3 rows to compute when multiplying:
+	* that is also the layout expected by shaders for skinning matrices.
+	*/
+	class ILARGIA_API AffineMatrix
+	{
+	public:
+
+		//! 3x4 Identity Matrix
+		static const AffineMatrix Identity;
+
+		//! First row (Index array are [0..3])
+		MatrixRow x;
+		//! Second row  (Index array are [4..7])
+		MatrixRow y;
+		//! Third row  (Index array are [8..11])
+		MatrixRow z;
+
+		AffineMatrix(MatrixRow x = MatrixRow()
+					 , MatrixRow y = MatrixRow()
+					 , MatrixRow z = MatrixRow());
+
+		//! Keep the affine part of a Matrix, its w column is ignored
+		explicit AffineMatrix(const Matrix& m);
+
+		//! Return the equivalent 4x4 Matrix
+		Matrix toMatrix() const;
+
+		//! Acces the {n}th row by copy
+		MatrixRow operator[](m::i32 i) const;
+
+		//! Acces the {n}th row by reference
+		MatrixRow& operator[](m::i32 i);
+
+		//! Return the determinant of the 3x3 linear part
+		m::f32 determinant() const;
+
+		/*!
+		* @brief Return the inverse matrix
+		* Computed from the cofactors of the 3x3 linear part,
+		* the translation being then rotated back
+		*/
+		AffineMatrix inverse() const;
+
+		//! Apply the whole transformation, translation included, to a point
+		Vector transformPoint(const Vector& p) const;
+
+		//! Apply the linear part of the transformation to a direction
+		Vector transformVector(const Vector& v) const;
+
+		/*!
+		* @brief Multiply with another AffineMatrix
+		* Same result as the Matrix multiplication: m is applied first
+		* @param m Another matrix
+		* @return A new AffineMatrix, result of the multiplication
+		*/
+		AffineMatrix operator*(const AffineMatrix& m) const;
+
+		//! Return true if matrices are equal
+		bool operator==(const AffineMatrix& m) const;
+		//! Return true if matrices are different
+		bool operator!=(const AffineMatrix& m) const;
+	};
+}
+
+m::system::Log& operator<<(m::system::Log& stream, const ilg::AffineMatrix& m);
+
+#endif
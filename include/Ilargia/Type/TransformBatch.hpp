@@ -0,0 +1,107 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#ifndef INCLUDE_ILARGIA_TRANSFORMBATCH_HPP
+#define INCLUDE_ILARGIA_TRANSFORMBATCH_HPP
+
+#include "Ilargia/Type/Vector.hpp"
+#include "Ilargia/Type/Quaternion.hpp"
+#include "Ilargia/Type/AffineMatrix.hpp"
+
+namespace ilg
+{
+	enum SimdLevel
+	{
+		SIMD_SCALAR,
+		SIMD_SSE,	//!< 4 transforms at once
+		SIMD_AVX2,	//!< 8 transforms at once
+	};
+
+	//! Best SimdLevel supported by both the build (see ILARGIA_NO_SIMD) and the CPU
+	ILARGIA_API SimdLevel getSupportedSimdLevel();
+
+	//! SimdLevel used by composeTransforms(), the supported one by default
+	ILARGIA_API SimdLevel getSimdLevel();
+
+	//! Force a SimdLevel (to compare them), clamped to the supported one
+	ILARGIA_API void setSimdLevel(SimdLevel level);
+
+	/*!
+	* @brief Position, rotation and scale of up to CAPACITY transforms, one array per attribute
+	* Each transform also has the world matrix of its parent, and the
+	* matrix receiving its own world matrix. A parent matrix may be the
+	* output of a previous transform of the same batch.
+	*/
+	struct ILARGIA_API TransformBatch
+	{
+		static const m::u32 CAPACITY = 256;
+
+		m::f32 px[CAPACITY], py[CAPACITY], pz[CAPACITY];
+		m::f32 qx[CAPACITY], qy[CAPACITY], qz[CAPACITY], qw[CAPACITY];
+		m::f32 sx[CAPACITY], sy[CAPACITY], sz[CAPACITY];
+		const AffineMatrix* parents[CAPACITY];
+		AffineMatrix* outputs[CAPACITY];
+		m::u32 count;
+
+		TransformBatch();
+
+		MUON_INLINE bool isFull() const
+		{
+			return count == CAPACITY;
+		}
+
+		MUON_INLINE void push(const Vector& position, const Quaternion& rotation, const Vector& scale, const AffineMatrix* parent, AffineMatrix* output)
+		{
+			px[count] = position.x;
+			py[count] = position.y;
+			pz[count] = position.z;
+			qx[count] = rotation.x;
+			qy[count] = rotation.y;
+			qz[count] = rotation.z;
+			qw[count] = rotation.w;
+			sx[count] = scale.x;
+			sy[count] = scale.y;
+			sz[count] = scale.z;
+			parents[count] = parent;
+			outputs[count] = output;
+			++count;
+		}
+	};
+
+	/*!
+	* @brief Compute the world matrix of every transform of the batch, then empty it
+	* Same result as parent.translate(position), rotate(rotation) then
+	* scale(scale), as an AffineMatrix, with the rotation and scale of 4 (SSE) or 8 (AVX2)
+	* transforms composed at once, see getSimdLevel(). Transforms are
+	* then multiplied by their parent in order, so a parent can be part
+	* of the batch as long as it comes first.
+	*/
+	ILARGIA_API void composeTransforms(TransformBatch& batch);
+}
+
+#endif
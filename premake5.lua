@@ -35,7 +35,8 @@ solution "Ilargia"
 	if os.is("windows") then
 		buildoptions { "" }
 	else
-		buildoptions { "--std=c++11" }
+		buildoptions { "--std=c++11", "-pthread" }
+		linkoptions { "-pthread" }
 	end
 
 	-- If option exists, then override G_Install
@@ -121,6 +122,10 @@ if _OPTIONS["unittests"] then
 	include("project_UnitTests")
 end
 
+if _OPTIONS["benchmarks"] then
+	include("project_Benchmarks")
+end
+
 ------------------------------
 -- Options
 ------------------------------
@@ -136,6 +141,11 @@ newoption {
 	description = "Enable compilation of unit tests",
 }
 
+newoption {
+	trigger     = "benchmarks",
+	description = "Enable compilation of benchmarks",
+}
+
 newoption {
 	trigger     = "buildmuon",
 	description = "Add Muon external project to the solution",
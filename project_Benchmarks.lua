@@ -0,0 +1,24 @@
+
+-- Benchmarks
+-------------------------------------------
+
+-- One executable per file of benchmark/, named IlargiaBenchmark_<File>
+for _,file in ipairs(os.matchfiles(os.getcwd().."/benchmark/*.cpp")) do
+	local name = path.getbasename(file)
+
+	project ("Ilargia_Benchmark_"..name)
+		dependson("Ilargia_Core")
+
+		language "C++"
+		kind "ConsoleApp"
+		targetname ("IlargiaBenchmark_"..name)
+		targetdir (SolutionRoot.."/bin")
+
+		files	{
+			file
+		}
+
+		links { "Muon_Core", "Ilargia_Core" }
+
+		filter {}
+end
@@ -0,0 +1,427 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <Muon/System/Assert.hpp>
+#include <Muon/Memory/Allocator.hpp>
+#include "Ilargia/Component/ArchetypeStorage.hpp"
+
+namespace ilg
+{
+	Archetype::Archetype(const std::vector<ArchetypeColumn>& columns)
+		: m_chunkCapacity(0)
+		, m_entityCount(0)
+	{
+		m_columns = MUON_NEW(ColumnList, columns);
+		m_offsets = MUON_NEW(OffsetList);
+		m_chunks = MUON_NEW(ChunkList);
+		m_addEdges = MUON_NEW(EdgeMap);
+		m_removeEdges = MUON_NEW(EdgeMap);
+
+		// Find how many entities fit in a chunk: entity ids first,
+		// then each column, aligned on its type requirement
+		m::u32 rowSize = sizeof(EntityId);
+		for (auto it = m_columns->begin(); it != m_columns->end(); ++it)
+		{
+			// Chunks come from malloc, which aligns on (at least) 16 bytes
+			MUON_ASSERT_BREAK(it->alignment <= 16
+							  , "Component alignment (%u) is not supported by Archetype chunks"
+							  , it->alignment);
+			rowSize += it->size;
+		}
+
+		m_offsets->resize(m_columns->size());
+		m::u32 capacity = ArchetypeStorage::CHUNK_SIZE / rowSize;
+		for (; capacity > 0; --capacity)
+		{
+			m::u32 offset = sizeof(EntityId) * capacity;
+			for (m::u32 i = 0; i < m_columns->size(); ++i)
+			{
+				m::u32 align = (*m_columns)[i].alignment;
+				offset = (offset + align - 1) / align * align;
+				(*m_offsets)[i] = offset;
+				offset += (*m_columns)[i].size * capacity;
+			}
+			if (offset <= ArchetypeStorage::CHUNK_SIZE)
+			{
+				break;
+			}
+		}
+		MUON_ASSERT_BREAK(capacity > 0, "Components are too big to fit in an Archetype chunk (Row size: %u)", rowSize);
+		m_chunkCapacity = capacity;
+	}
+
+	Archetype::~Archetype()
+	{
+		while (m_entityCount > 0)
+		{
+			_removeRow(m_entityCount - 1, true);
+		}
+		MUON_DELETE(m_columns);
+		MUON_DELETE(m_offsets);
+		MUON_DELETE(m_chunks);
+		MUON_DELETE(m_addEdges);
+		MUON_DELETE(m_removeEdges);
+	}
+
+	m::i32 Archetype::getColumnIndex(m::u64 type) const
+	{
+		for (m::u32 i = 0; i < m_columns->size(); ++i)
+		{
+			if ((*m_columns)[i].type == type)
+			{
+				return (m::i32)i;
+			}
+		}
+		return m::INVALID_INDEX;
+	}
+
+	bool Archetype::hasType(m::u64 type) const
+	{
+		return getColumnIndex(type) != m::INVALID_INDEX;
+	}
+
+	const std::vector<ArchetypeColumn>& Archetype::getColumns() const
+	{
+		return *m_columns;
+	}
+
+	m::u32 Archetype::getChunkCapacity() const
+	{
+		return m_chunkCapacity;
+	}
+
+	m::u32 Archetype::getChunkCount() const
+	{
+		return m_chunks->size();
+	}
+
+	m::u32 Archetype::getEntityCount() const
+	{
+		return m_entityCount;
+	}
+
+	const ArchetypeChunk& Archetype::getChunk(m::u32 chunk) const
+	{
+		return (*m_chunks)[chunk];
+	}
+
+	void* Archetype::_getElement(m::u32 row, m::i32 column) const
+	{
+		const ArchetypeChunk& chunk = (*m_chunks)[row / m_chunkCapacity];
+		return (m::u8*)getColumn(chunk, column) + (*m_columns)[column].size * (row % m_chunkCapacity);
+	}
+
+	m::u32 Archetype::_allocRow(EntityId id)
+	{
+		m::u32 row = m_entityCount;
+		if (row / m_chunkCapacity >= m_chunks->size())
+		{
+			ArchetypeChunk chunk;
+			chunk.buffer = (m::u8*)malloc(ArchetypeStorage::CHUNK_SIZE);
+			chunk.count = 0;
+			MUON_ASSERT_BREAK(chunk.buffer != NULL, "Archetype chunk can't be allocated!");
+			m_chunks->push_back(chunk);
+		}
+
+		ArchetypeChunk& chunk = (*m_chunks)[row / m_chunkCapacity];
+		getEntities(chunk)[chunk.count] = id;
+		++chunk.count;
+		++m_entityCount;
+		return row;
+	}
+
+	EntityId Archetype::_removeRow(m::u32 row, bool destroy)
+	{
+		// Fill the hole with the last row, so chunks stay packed
+		m::u32 last = m_entityCount - 1;
+		ArchetypeChunk& chunk = (*m_chunks)[row / m_chunkCapacity];
+		ArchetypeChunk& lastChunk = (*m_chunks)[last / m_chunkCapacity];
+		EntityId moved = INVALID_ENTITY;
+		for (m::u32 i = 0; i < m_columns->size(); ++i)
+		{
+			void* element = _getElement(row, i);
+			if (destroy)
+			{
+				(*m_columns)[i].destroy(element);
+			}
+			if (row != last)
+			{
+				(*m_columns)[i].relocate(element, _getElement(last, i));
+			}
+		}
+		if (row != last)
+		{
+			moved = getEntities(lastChunk)[last % m_chunkCapacity];
+			getEntities(chunk)[row % m_chunkCapacity] = moved;
+		}
+
+		--lastChunk.count;
+		--m_entityCount;
+		if (lastChunk.count == 0)
+		{
+			free(lastChunk.buffer);
+			m_chunks->pop_back();
+		}
+		return moved;
+	}
+
+	ArchetypeStorage::ArchetypeStorage()
+	{
+		m_archetypes = MUON_NEW(ArchetypeMap);
+		m_archetypeList = MUON_NEW(ArchetypeList);
+		m_locations = MUON_NEW(LocationList);
+		m_emptyArchetype = _getArchetype(std::vector<ArchetypeColumn>());
+	}
+
+	ArchetypeStorage::~ArchetypeStorage()
+	{
+		for (auto it = m_archetypeList->begin(); it != m_archetypeList->end(); ++it)
+		{
+			MUON_DELETE(*it);
+		}
+		MUON_DELETE(m_archetypes);
+		MUON_DELETE(m_archetypeList);
+		MUON_DELETE(m_locations);
+	}
+
+	void ArchetypeStorage::addEntity(EntityId id)
+	{
+		MUON_ASSERT(!hasEntity(id), "Entity %u is already stored!", id);
+		if (hasEntity(id))
+		{
+			return;
+		}
+
+		m::u32 index = getEntityIndex(id);
+		if (index >= m_locations->size())
+		{
+			EntityLocation invalid = { INVALID_ENTITY, NULL, 0 };
+			m_locations->resize(index + 1, invalid);
+		}
+		EntityLocation& location = (*m_locations)[index];
+		location.id = id;
+		location.archetype = m_emptyArchetype;
+		location.row = m_emptyArchetype->_allocRow(id);
+	}
+
+	bool ArchetypeStorage::removeEntity(EntityId id)
+	{
+		EntityLocation* location = _getLocation(id);
+		if (location == NULL)
+		{
+			return false;
+		}
+
+		EntityId moved = location->archetype->_removeRow(location->row, true);
+		if (moved != INVALID_ENTITY)
+		{
+			(*m_locations)[getEntityIndex(moved)].row = location->row;
+		}
+		location->id = INVALID_ENTITY;
+		location->archetype = NULL;
+		return true;
+	}
+
+	bool ArchetypeStorage::hasEntity(EntityId id) const
+	{
+		return _getLocation(id) != NULL;
+	}
+
+	m::u32 ArchetypeStorage::getArchetypeCount() const
+	{
+		return m_archetypeList->size();
+	}
+
+	Archetype* ArchetypeStorage::getArchetype(m::u32 index) const
+	{
+		return (*m_archetypeList)[index];
+	}
+
+	void* ArchetypeStorage::_addComponent(EntityId id, const ArchetypeColumn& column)
+	{
+		EntityLocation* location = _getLocation(id);
+		MUON_ASSERT(location != NULL, "Entity %u is not stored!", id);
+		if (location == NULL)
+		{
+			return NULL;
+		}
+
+		Archetype* source = location->archetype;
+		m::i32 existing = source->getColumnIndex(column.type);
+		if (existing != m::INVALID_INDEX)
+		{
+			return source->_getElement(location->row, existing);
+		}
+
+		// Follow the cached edge, or find the archetype with the new type
+		Archetype* target = NULL;
+		auto edge = source->m_addEdges->find(column.type);
+		if (edge != source->m_addEdges->end())
+		{
+			target = edge->second;
+		}
+		else
+		{
+			std::vector<ArchetypeColumn> columns = *source->m_columns;
+			columns.push_back(column);
+			target = _getArchetype(columns);
+			(*source->m_addEdges)[column.type] = target;
+			(*target->m_removeEdges)[column.type] = source;
+		}
+
+		_moveEntity(*location, target);
+		m::i32 index = target->getColumnIndex(column.type);
+		void* element = target->_getElement(location->row, index);
+		column.construct(element);
+		return element;
+	}
+
+	bool ArchetypeStorage::_removeComponent(EntityId id, m::u64 type)
+	{
+		EntityLocation* location = _getLocation(id);
+		if (location == NULL || !location->archetype->hasType(type))
+		{
+			return false;
+		}
+
+		Archetype* source = location->archetype;
+		Archetype* target = NULL;
+		auto edge = source->m_removeEdges->find(type);
+		if (edge != source->m_removeEdges->end())
+		{
+			target = edge->second;
+		}
+		else
+		{
+			std::vector<ArchetypeColumn> columns;
+			for (auto it = source->m_columns->begin(); it != source->m_columns->end(); ++it)
+			{
+				if (it->type != type)
+				{
+					columns.push_back(*it);
+				}
+			}
+			target = _getArchetype(columns);
+			(*source->m_removeEdges)[type] = target;
+			(*target->m_addEdges)[type] = source;
+		}
+
+		m::i32 column = source->getColumnIndex(type);
+		(*source->m_columns)[column].destroy(source->_getElement(location->row, column));
+		_moveEntity(*location, target);
+		return true;
+	}
+
+	void* ArchetypeStorage::_getComponent(EntityId id, m::u64 type) const
+	{
+		EntityLocation* location = _getLocation(id);
+		if (location == NULL)
+		{
+			return NULL;
+		}
+		m::i32 column = location->archetype->getColumnIndex(type);
+		return (column != m::INVALID_INDEX ? location->archetype->_getElement(location->row, column) : NULL);
+	}
+
+	bool ArchetypeStorage::_matchTypes(const Archetype* archetype, const m::u64* types, m::u32 count) const
+	{
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			if (!archetype->hasType(types[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ArchetypeStorage::EntityLocation* ArchetypeStorage::_getLocation(EntityId id) const
+	{
+		m::u32 index = getEntityIndex(id);
+		if (id == INVALID_ENTITY || index >= m_locations->size() || (*m_locations)[index].id != id)
+		{
+			return NULL;
+		}
+		return const_cast<EntityLocation*>(&(*m_locations)[index]);
+	}
+
+	Archetype* ArchetypeStorage::_getArchetype(const std::vector<ArchetypeColumn>& columns)
+	{
+		// Archetypes are identified by their sorted type list
+		std::vector<ArchetypeColumn> sorted = columns;
+		std::sort(sorted.begin(), sorted.end(), [](const ArchetypeColumn& l, const ArchetypeColumn& r)
+		{
+			return l.type < r.type;
+		});
+
+		std::vector<m::u64> key;
+		for (auto it = sorted.begin(); it != sorted.end(); ++it)
+		{
+			key.push_back(it->type);
+		}
+
+		auto it = m_archetypes->find(key);
+		if (it != m_archetypes->end())
+		{
+			return it->second;
+		}
+
+		Archetype* archetype = MUON_NEW(Archetype, sorted);
+		(*m_archetypes)[key] = archetype;
+		m_archetypeList->push_back(archetype);
+		return archetype;
+	}
+
+	void ArchetypeStorage::_moveEntity(EntityLocation& location, Archetype* target)
+	{
+		// Columns existing in both archetypes are moved, the others are
+		// left to the caller (already destroyed, or to be constructed)
+		Archetype* source = location.archetype;
+		m::u32 row = target->_allocRow(location.id);
+		for (m::u32 i = 0; i < source->m_columns->size(); ++i)
+		{
+			m::i32 column = target->getColumnIndex((*source->m_columns)[i].type);
+			if (column != m::INVALID_INDEX)
+			{
+				(*source->m_columns)[i].relocate(target->_getElement(row, column), source->_getElement(location.row, i));
+			}
+		}
+
+		// Fill the hole in the source, without destroying anything: moved
+		// columns have been destroyed by relocate()
+		EntityId moved = source->_removeRow(location.row, false);
+		if (moved != INVALID_ENTITY)
+		{
+			(*m_locations)[getEntityIndex(moved)].row = location.row;
+		}
+
+		location.archetype = target;
+		location.row = row;
+	}
+}
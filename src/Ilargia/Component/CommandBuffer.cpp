@@ -0,0 +1,261 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#include <algorithm>
+#include <Muon/System/Assert.hpp>
+#include "Ilargia/System/JobSystem.hpp"
+#include "Ilargia/Component/Entity.hpp"
+#include "Ilargia/Component/CommandBuffer.hpp"
+
+namespace
+{
+	struct ComponentCommand
+	{
+		m::u32 typeIndex;
+		ilg::EntityId entity;
+		bool add;
+
+		// Stable sorted: commands on the same Component keep their recording order
+
+		bool operator<(const ComponentCommand& c) const
+		{
+			if (typeIndex != c.typeIndex)
+			{
+				return typeIndex < c.typeIndex;
+			}
+			return ilg::getEntityIndex(entity) < ilg::getEntityIndex(c.entity);
+		}
+	};
+}
+
+namespace ilg
+{
+	CommandBuffer::CommandBuffer()
+		: m_createCount(0)
+	{
+		typedef std::vector<Command> CommandList;
+		typedef std::vector<EntityId> EntityList;
+		m_commands = MUON_NEW(CommandList);
+		m_created = MUON_NEW(EntityList);
+	}
+
+	CommandBuffer::~CommandBuffer()
+	{
+		MUON_DELETE(m_commands);
+		MUON_DELETE(m_created);
+	}
+
+	PendingEntity CommandBuffer::create()
+	{
+		PendingEntity e = { m_createCount };
+		++m_createCount;
+		return e;
+	}
+
+	void CommandBuffer::destroy(const Target& entity)
+	{
+		_record(COMMAND_DESTROY, entity, 0, false);
+	}
+
+	void CommandBuffer::setParent(const Target& entity, const Target& parent)
+	{
+		_record(COMMAND_SET_PARENT, entity, parent.value, parent.pending);
+	}
+
+	m::u32 CommandBuffer::size() const
+	{
+		return (m::u32)m_commands->size() + m_createCount;
+	}
+
+	bool CommandBuffer::empty() const
+	{
+		return size() == 0;
+	}
+
+	void CommandBuffer::clear()
+	{
+		m_commands->clear();
+		m_created->clear();
+		m_createCount = 0;
+	}
+
+	void CommandBuffer::playback()
+	{
+		CommandBuffer* self = this;
+		_playback(&self, 1);
+	}
+
+	void CommandBuffer::_record(CommandType type, const Target& entity, m::u32 arg, bool pendingArg)
+	{
+		MUON_ASSERT(!entity.pending || entity.value < m_createCount, "PendingEntity doesn't come from this buffer!");
+		Command c;
+		c.type = (m::u16)type;
+		c.flags = (m::u16)((entity.pending ? COMMAND_PENDING_ENTITY : 0) | (pendingArg ? COMMAND_PENDING_ARG : 0));
+		c.entity = entity.value;
+		c.arg = arg;
+		m_commands->push_back(c);
+	}
+
+	EntityId CommandBuffer::_resolve(m::u32 value, bool pending) const
+	{
+		return (pending ? (*m_created)[value] : value);
+	}
+
+	void CommandBuffer::_playback(CommandBuffer* const* buffers, m::u32 count)
+	{
+		EntityManager& entities = EntityManager::getInstance();
+
+		// Create entities first, so every other command can refer to them
+		m::u32 componentCount = 0;
+		for (m::u32 b = 0; b < count; ++b)
+		{
+			CommandBuffer* buffer = buffers[b];
+			buffer->m_created->reserve(buffer->m_createCount);
+			for (m::u32 i = 0; i < buffer->m_createCount; ++i)
+			{
+				buffer->m_created->push_back(entities.create()->getId());
+			}
+			componentCount += (m::u32)buffer->m_commands->size();
+		}
+
+		// Hierarchy changes depend on each other: keep recording order
+		std::vector<ComponentCommand> components;
+		components.reserve(componentCount);
+		for (m::u32 b = 0; b < count; ++b)
+		{
+			CommandBuffer* buffer = buffers[b];
+			for (auto it = buffer->m_commands->begin(); it != buffer->m_commands->end(); ++it)
+			{
+				ComponentCommand c = { it->arg, buffer->_resolve(it->entity, (it->flags & COMMAND_PENDING_ENTITY) != 0), it->type == COMMAND_ADD_COMPONENT };
+				switch (it->type)
+				{
+					case COMMAND_SET_PARENT:
+						if (Entity* e = entities.get(c.entity))
+						{
+							EntityId parent = buffer->_resolve(it->arg, (it->flags & COMMAND_PENDING_ARG) != 0);
+							e->setParent(entities.get(parent));
+						}
+						break;
+					case COMMAND_ADD_COMPONENT:
+					case COMMAND_REMOVE_COMPONENT:
+						components.push_back(c);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		// Components are applied type by type, to touch one manager storage at a time.
+		// Adds and removes of a given Component stay in recording order, so
+		// removing then adding it again leaves the Entity with a new one
+		std::stable_sort(components.begin(), components.end());
+		for (auto it = components.begin(); it != components.end(); ++it)
+		{
+			if (Entity* e = entities.get(it->entity))
+			{
+				if (it->add)
+				{
+					e->_addComponent(it->typeIndex);
+				}
+				else
+				{
+					e->_removeComponent(it->typeIndex);
+				}
+			}
+		}
+
+		for (m::u32 b = 0; b < count; ++b)
+		{
+			CommandBuffer* buffer = buffers[b];
+			for (auto it = buffer->m_commands->begin(); it != buffer->m_commands->end(); ++it)
+			{
+				if (it->type == COMMAND_DESTROY)
+				{
+					entities.destroy(buffer->_resolve(it->entity, (it->flags & COMMAND_PENDING_ENTITY) != 0));
+				}
+			}
+			buffer->clear();
+		}
+	}
+
+	CommandQueue::CommandQueue()
+	{
+		typedef std::vector<CommandBuffer*> BufferList;
+		m_buffers = MUON_NEW(BufferList);
+		// Usable before init(): a single buffer, for the main thread
+		init(1);
+	}
+
+	CommandQueue::~CommandQueue()
+	{
+		_release();
+		MUON_DELETE(m_buffers);
+	}
+
+	void CommandQueue::init(m::u32 threadCount)
+	{
+		MUON_ASSERT_BREAK(threadCount > 0, "CommandQueue requires at least one thread!");
+
+		// Keep commands that may have been recorded on the main thread
+		CommandBuffer* mainBuffer = NULL;
+		if (!m_buffers->empty())
+		{
+			mainBuffer = (*m_buffers)[0];
+			(*m_buffers)[0] = NULL;
+		}
+		_release();
+
+		m_buffers->resize(threadCount);
+		(*m_buffers)[0] = (mainBuffer != NULL ? mainBuffer : MUON_NEW(CommandBuffer));
+		for (m::u32 i = 1; i < threadCount; ++i)
+		{
+			(*m_buffers)[i] = MUON_NEW(CommandBuffer);
+		}
+	}
+
+	CommandBuffer& CommandQueue::getBuffer()
+	{
+		m::u32 thread = system::JobSystem::getThreadIndex();
+		MUON_ASSERT_BREAK(thread < m_buffers->size(), "No CommandBuffer for thread %u!", thread);
+		return *(*m_buffers)[thread];
+	}
+
+	void CommandQueue::flush()
+	{
+		CommandBuffer::_playback(m_buffers->data(), (m::u32)m_buffers->size());
+	}
+
+	void CommandQueue::_release()
+	{
+		for (auto it = m_buffers->begin(); it != m_buffers->end(); ++it)
+		{
+			MUON_DELETE(*it);
+		}
+		m_buffers->clear();
+	}
+}
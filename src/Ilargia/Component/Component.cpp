@@ -25,80 +25,88 @@
 *
 *************************************************************************/
 
+#include <type_traits>
 #include "Ilargia/Manager/IComponentManager.hpp"
 #include "Ilargia/Manager/ManagerFactory.hpp"
 #include "Ilargia/Component/Component.hpp"
 
 namespace ilg
 {
+	static_assert(sizeof(Component) == 12, "Component handle is expected to stay 12 bytes");
+	static_assert(std::is_trivially_copyable<Component>::value, "Component handle must be trivially copyable");
+
 	Component::Component()
-		: m_instanceTypeId(MUON_META(Component)->id())
+		: m_typeIndex(manager::INVALID_TYPE_INDEX)
 		, m_instanceIndex(m::INVALID_INDEX)
-		, m_instanceName(MUON_META(Component)->name())
+		, m_instanceGeneration(0)
 	{
 	}
 
-	Component::Component(m::u64 type, m::i32 instance, const m::String& name)
-		: m_instanceTypeId(type)
+	Component::Component(m::u32 typeIndex, m::i32 instance, m::u32 generation)
+		: m_typeIndex(typeIndex)
 		, m_instanceIndex(instance)
-		, m_instanceName(name)
+		, m_instanceGeneration(generation)
 	{
 	}
 
-	Component::Component(const Component& c)
-		: m_instanceTypeId(c.m_instanceTypeId)
-		, m_instanceIndex(c.m_instanceIndex)
-		, m_instanceName(c.m_instanceName)
+	m::i32 Component::getInstanceIndex() const
 	{
+		return m_instanceIndex;
 	}
 
-	Component& Component::operator=(const Component& c)
+	m::u32 Component::getInstanceGeneration() const
 	{
-		if (this != &c)
-		{
-			m_instanceTypeId = c.m_instanceTypeId;
-			m_instanceIndex = c.m_instanceIndex;
-			m_instanceName = c.m_instanceName;
-		}
-		return *this;
+		return m_instanceGeneration;
 	}
 
-	m::i32 Component::getInstanceIndex() const
+	m::u32 Component::getTypeIndex() const
 	{
-		return m_instanceIndex;
+		return m_typeIndex;
 	}
 
 	m::u64 Component::getInstanceTypeId() const
 	{
-		return m_instanceTypeId;
+		if (m_typeIndex == manager::INVALID_TYPE_INDEX)
+		{
+			return MUON_META(Component)->id();
+		}
+		return manager::ManagerFactory::getInstance().getComponentTypeInfo(m_typeIndex).id;
 	}
 
 	m::String Component::getInstanceName() const
 	{
-		return m_instanceName;
+		if (m_typeIndex == manager::INVALID_TYPE_INDEX)
+		{
+			return MUON_META(Component)->name();
+		}
+		return manager::ManagerFactory::getInstance().getComponentTypeInfo(m_typeIndex).name;
 	}
 
-	void* Component::_cast(m::u64 type, const char* type_name) const
+	void* Component::_cast(m::u32 typeIndex) const
 	{
 		MUON_ASSERT(m_instanceIndex != m::INVALID_INDEX, "Component instance is invalid!");
-		MUON_ASSERT(type != m::INVALID_INDEX, "Trying to cast to an invalid type!");
-		if (type == m::INVALID_INDEX
-			|| m_instanceIndex == m::INVALID_INDEX)
+		if (m_instanceIndex == m::INVALID_INDEX)
 		{
 			return NULL;
 		}
 
-		manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManager(type);
+		manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManagerFromTypeIndex(typeIndex);
 		MUON_ASSERT(manager != NULL,
-					"There is no ComponentManager matching the type %u (%s)",
-					type, type_name);
+					"There is no ComponentManager matching the type index %u",
+					typeIndex);
 
 		if (manager != NULL)
 		{
-			MUON_ASSERT(type == m_instanceTypeId,
+			MUON_ASSERT(typeIndex == m_typeIndex,
 						"Cast Type (%s) does not match Component Type (%s)",
-						type_name, m_instanceTypeId);
-			if (type == m_instanceTypeId)
+						manager::ManagerFactory::getInstance().getComponentTypeInfo(typeIndex).name.cStr(), getInstanceName().cStr());
+			MUON_ASSERT(manager->isComponentAlive(*this), "Component handle is stale (%s)", getInstanceName().cStr());
+			// The slot may hold another Component since: never resolve a stale handle
+			if (!manager->isComponentAlive(*this))
+			{
+				return NULL;
+			}
+			if (typeIndex == m_typeIndex)
 			{
 				return manager->getComponent(m_instanceIndex);
 			}
@@ -25,25 +25,34 @@
 *
 *************************************************************************/
 
+#include <cstdlib>
+#include <cstring>
 #include <Muon/System/Assert.hpp>
 #include <Muon/Memory/Allocator.hpp>
 #include "Ilargia/Manager/ManagerFactory.hpp"
+#include "Ilargia/System/JobSystem.hpp"
+#include "Ilargia/Component/ArchetypeStorage.hpp"
 #include "Ilargia/Component/Entity.hpp"
 
 namespace ilg
 {
-	Entity::Entity()
-		: m_parent(NULL)
+	Entity::Entity(EntityId id)
+		: m_id(id)
+		, m_alive(false)
+		, m_heapComponents(NULL)
+		, m_heapCapacity(0)
+		, m_parent(NULL)
+		, m_firstChild(NULL)
+		, m_lastChild(NULL)
+		, m_prevSibling(NULL)
+		, m_nextSibling(NULL)
+		, m_childCount(0)
 	{
-		typedef ComponentStorage<Component, 8> ComponentArray;
-		m_components = MUON_NEW(ComponentArray);
-		m_children = MUON_NEW(std::deque<Entity*>);
 	}
 
 	Entity::~Entity()
 	{
-		MUON_DELETE(m_components);
-		MUON_DELETE(m_children);
+		free(m_heapComponents);
 	}
 
 	Entity* Entity::create()
@@ -56,6 +65,11 @@ namespace ilg
 		EntityManager::getInstance().destroy(entity);
 	}
 
+	EntityId Entity::getId() const
+	{
+		return m_id;
+	}
+
 	void Entity::setParent(Entity* parent)
 	{
 		// If already my parent, skip
@@ -64,28 +78,10 @@ namespace ilg
 			return;
 		}
 
-		// Update current parent, remove me from its children
-		Entity* oldParent = m_parent;
-		if (m_parent != NULL)
-		{
-			for (auto it = m_parent->m_children->begin(); it != m_parent->m_children->end(); ++it)
-			{
-				if (*it == this)
-				{
-					m_parent->m_children->erase(it);
-					break;
-				}
-			}
-		}
-
-		// Add me in new parent children
-		if (parent != NULL)
-		{
-			parent->m_children->push_back(this);
-		}
-
 		// Update and notify
-		m_parent = parent;
+		Entity* oldParent = m_parent;
+		_unlink();
+		_link(parent);
 		EntityManager::getInstance().dispatchEntityHierarchyChange(this, oldParent, parent);
 	}
 
@@ -96,7 +92,7 @@ namespace ilg
 			// Case the child we want is our parent
 			if (m_parent == child)
 			{
-				m_parent = NULL;
+				_unlink();
 				EntityManager::getInstance().dispatchEntityHierarchyChange(this, child, m_parent);
 			}
 
@@ -112,8 +108,7 @@ namespace ilg
 			}
 
 			// Update and notify
-			child->m_parent = this;
-			m_children->push_back(child);
+			child->_link(this);
 			EntityManager::getInstance().dispatchEntityHierarchyChange(child, oldParent, this);
 		}
 	}
@@ -122,19 +117,9 @@ namespace ilg
 	{
 		if (m_parent != NULL)
 		{
-			// Search for myself in parent children and remove me
-			Entity* oldParent = m_parent;
-			for (auto it = m_parent->m_children->begin(); it != m_parent->m_children->end(); ++it)
-			{
-				if (*it == this)
-				{
-					m_parent->m_children->erase(it);
-					break;
-				}
-			}
-
 			// Update and notify
-			m_parent = NULL;
+			Entity* oldParent = m_parent;
+			_unlink();
 			EntityManager::getInstance().dispatchEntityHierarchyChange(this, oldParent, m_parent);
 		}
 	}
@@ -143,106 +128,408 @@ namespace ilg
 	{
 		if (child->m_parent == this)
 		{
-			// Iterate and remove it
-			for (auto it = m_children->begin(); it != m_children->end(); ++it)
+			// Update and notify
+			child->_unlink();
+			EntityManager::getInstance().dispatchEntityHierarchyChange(child, this, child->m_parent);
+		}
+	}
+
+	Entity* Entity::getParent() const
+	{
+		return m_parent;
+	}
+
+	Entity* Entity::getFirstChild() const
+	{
+		return m_firstChild;
+	}
+
+	Entity* Entity::getLastChild() const
+	{
+		return m_lastChild;
+	}
+
+	Entity* Entity::getNextSibling() const
+	{
+		return m_nextSibling;
+	}
+
+	Entity* Entity::getPrevSibling() const
+	{
+		return m_prevSibling;
+	}
+
+	m::u32 Entity::getChildCount() const
+	{
+		return m_childCount;
+	}
+
+	Entity* Entity::getNextInHierarchy(const Entity* root) const
+	{
+		if (m_firstChild != NULL)
+		{
+			return m_firstChild;
+		}
+
+		// No child: go up until an ancestor (below root) has a next sibling
+		const Entity* e = this;
+		while (e != root && e != NULL)
+		{
+			if (e->m_nextSibling != NULL)
 			{
-				if (*it == child)
-				{
-					m_children->erase(it);
-					break;
-				}
+				return e->m_nextSibling;
 			}
+			e = e->m_parent;
+		}
+		return NULL;
+	}
 
-			// Update and notify
-			child->m_parent = NULL;
-			EntityManager::getInstance().dispatchEntityHierarchyChange(child, this, child->m_parent);
+	void Entity::_link(Entity* parent)
+	{
+		MUON_ASSERT(m_parent == NULL, "Entity must be unlinked before being linked again!");
+		m_parent = parent;
+		if (parent != NULL)
+		{
+			m_prevSibling = parent->m_lastChild;
+			m_nextSibling = NULL;
+			if (parent->m_lastChild != NULL)
+			{
+				parent->m_lastChild->m_nextSibling = this;
+			}
+			else
+			{
+				parent->m_firstChild = this;
+			}
+			parent->m_lastChild = this;
+			++parent->m_childCount;
+		}
+	}
+
+	void Entity::_unlink()
+	{
+		if (m_parent != NULL)
+		{
+			if (m_prevSibling != NULL)
+			{
+				m_prevSibling->m_nextSibling = m_nextSibling;
+			}
+			else
+			{
+				m_parent->m_firstChild = m_nextSibling;
+			}
+
+			if (m_nextSibling != NULL)
+			{
+				m_nextSibling->m_prevSibling = m_prevSibling;
+			}
+			else
+			{
+				m_parent->m_lastChild = m_prevSibling;
+			}
+			--m_parent->m_childCount;
 		}
+		m_parent = NULL;
+		m_prevSibling = NULL;
+		m_nextSibling = NULL;
 	}
 
-	Component Entity::_addComponent(m::u64 type)
+	Component Entity::_addComponent(m::u32 typeIndex)
 	{
-		manager::IBaseManager* manager = ILARGIA_GET_COMPONENT_MANAGER_FROM_TYPE(manager::IBaseManager, type);
+		// Only one Component of each type per Entity
+		if (m_componentMask.test(typeIndex))
+		{
+			return _getComponent(typeIndex);
+		}
+
+		manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManagerFromTypeIndex(typeIndex);
 		Component c;
 		if (manager)
 		{
-			c = manager->createComponent();
-			m_components->add(c);
+			c = manager->createOwnedComponent(m_id);
+			_bindComponent(c);
 			manager->onComponentAdded(this, c);
 		}
 		return c;
 	}
 
-	Component Entity::_getComponent(m::u64 type)
+	void Entity::_bindComponent(const Component& component)
 	{
-		for (m::i32 i = 0; i < m_components->size(); ++i)
+		const m::u32 typeIndex = component.getTypeIndex();
+		MUON_ASSERT_BREAK(typeIndex < ILARGIA_MAX_COMPONENT_TYPES
+						  , "Component type index out of ComponentMask range! (%u)"
+						  , typeIndex);
+		MUON_ASSERT(!m_componentMask.test(typeIndex), "Entity already has a Component of this type!");
+
+		const m::u32 count = m_componentMask.count();
+		const m::u32 capacity = (m_heapComponents != NULL ? m_heapCapacity : ILARGIA_ENTITY_INLINE_COMPONENTS);
+		if (count == capacity)
 		{
-			Component c = m_components->get(i);
-			if (c.getInstanceTypeId() == type)
-			{
-				return c;
-			}
+			// Handles are trivially copyable: move them all to a bigger heap array
+			const m::u32 newCapacity = capacity * 2;
+			Component* handles = (Component*)malloc(sizeof(Component) * newCapacity);
+			MUON_ASSERT_BREAK(handles != NULL, "Component handles can't be allocated!");
+			memcpy((void*)handles, (const void*)_getHandles(), sizeof(Component) * count);
+			free(m_heapComponents);
+			m_heapComponents = handles;
+			m_heapCapacity = newCapacity;
 		}
-		return Component();
+
+		Component* handles = _getHandles();
+		const m::u32 slot = m_componentMask.rank(typeIndex);
+		memmove((void*)(handles + slot + 1), (const void*)(handles + slot), sizeof(Component) * (count - slot));
+		handles[slot] = component;
+		m_componentMask.set(typeIndex);
 	}
 
-	bool Entity::_removeComponent(m::u64 type)
+	bool Entity::_removeComponent(m::u32 typeIndex)
 	{
-		manager::IBaseManager* manager = ILARGIA_GET_COMPONENT_MANAGER_FROM_TYPE(manager::IBaseManager, type);
-		Component c;
-		if (manager)
+		if (!m_componentMask.test(typeIndex))
 		{
-			for (m::i32 i = 0; i < m_components->size(); ++i)
+			return false;
+		}
+
+		manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManagerFromTypeIndex(typeIndex);
+		Component* handles = _getHandles();
+		const m::u32 slot = m_componentMask.rank(typeIndex);
+		Component c = handles[slot];
+		manager->onComponentRemoved(this, c);
+		manager->destroyComponent(c);
+		const m::u32 count = m_componentMask.count();
+		memmove((void*)(handles + slot), (const void*)(handles + slot + 1), sizeof(Component) * (count - slot - 1));
+		m_componentMask.reset(typeIndex);
+		return true;
+	}
+
+	void Entity::_removeAllComponents()
+	{
+		// Highest type index first, skipping the words without any Component:
+		// handles are packed in type index order, so walk them backward too
+		const Component* handles = _getHandles();
+		m::u32 slot = m_componentMask.count();
+		for (m::u32 typeIndex = ILARGIA_MAX_COMPONENT_TYPES; typeIndex-- > 0;)
+		{
+			if (m_componentMask.getWord(typeIndex >> 6) == 0)
 			{
-				Component c = m_components->get(i);
-				if (c.getInstanceTypeId() == type)
-				{
-					manager->onComponentRemoved(this, c);
-					manager->destroyComponent(c);
-					m_components->remove(i);
-					return true;
-				}
+				typeIndex &= ~63u;
+				continue;
+			}
+			if (!m_componentMask.test(typeIndex))
+			{
+				continue;
+			}
+
+			Component c = handles[--slot];
+			manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManagerFromTypeIndex(typeIndex);
+			if (manager)
+			{
+				manager->onComponentRemoved(this, c);
+				manager->destroyComponent(c);
 			}
 		}
-		return false;
+		m_componentMask.clear();
+		// The slot is recycled by another Entity: start again with inline handles
+		free(m_heapComponents);
+		m_heapComponents = NULL;
+		m_heapCapacity = 0;
 	}
 
 	EntityManager::EntityManager()
+		: m_slotCount(0)
+		, m_aliveCount(0)
 	{
-		typedef std::deque<Entity*> EntityDeque;
-		m_entities = MUON_NEW(EntityDeque);
+		typedef std::vector<Entity*> EntityPages;
+		typedef std::deque<m::u32> SlotDeque;
+		typedef std::vector<HierarchyEvent> HierarchyEventList;
+		m_pages = MUON_NEW(EntityPages);
+		m_freeSlots = MUON_NEW(SlotDeque);
+		m_hierarchyEvents = MUON_NEW(HierarchyEventList);
+		m_archetypeStorage = MUON_NEW(ArchetypeStorage);
 	}
 
 	EntityManager::~EntityManager()
 	{
-		MUON_DELETE(m_entities);
+		for (m::u32 i = 0; i < m_slotCount; ++i)
+		{
+			_getSlot(i)->~Entity();
+		}
+		for (auto it = m_pages->begin(); it != m_pages->end(); ++it)
+		{
+			free(*it);
+		}
+		MUON_DELETE(m_pages);
+		MUON_DELETE(m_freeSlots);
+		MUON_DELETE(m_hierarchyEvents);
+		MUON_DELETE(m_archetypeStorage);
+	}
+
+	Entity* EntityManager::_getSlot(m::u32 index) const
+	{
+		return (*m_pages)[index / ENTITY_PAGE_SIZE] + (index % ENTITY_PAGE_SIZE);
 	}
 
 	Entity* EntityManager::create()
 	{
-		Entity* e = MUON_NEW(Entity);
-		m_entities->push_back(e);
+		Entity* e = NULL;
+		// Oldest free slot first, so generations wrap as late as possible
+		if (!m_freeSlots->empty())
+		{
+			e = _getSlot(m_freeSlots->front());
+			m_freeSlots->pop_front();
+		}
+		else
+		{
+			MUON_ASSERT_BREAK(m_slotCount <= ENTITY_INDEX_MASK, "Too many entities! (Max: %u)", ENTITY_INDEX_MASK);
+			if (m_slotCount % ENTITY_PAGE_SIZE == 0)
+			{
+				Entity* page = (Entity*)malloc(sizeof(Entity) * ENTITY_PAGE_SIZE);
+				MUON_ASSERT_BREAK(page != NULL, "Entity page can't be allocated!");
+				m_pages->push_back(page);
+			}
+			e = _getSlot(m_slotCount);
+			new (e) Entity(makeEntityId(m_slotCount, 0));
+			++m_slotCount;
+		}
+		e->m_alive = true;
+		++m_aliveCount;
 		return e;
 	}
 
-	void EntityManager::destroy(Entity* e)
+	void EntityManager::create(Entity** out, m::u32 count)
 	{
-		for (auto it = m_entities->begin(); it != m_entities->end(); ++it)
+		m::u32 created = 0;
+		for (; created < count && !m_freeSlots->empty(); ++created)
+		{
+			out[created] = _getSlot(m_freeSlots->front());
+			m_freeSlots->pop_front();
+		}
+
+		const m::u32 remaining = count - created;
+		if (remaining > 0)
 		{
-			if ((*it) == e)
+			MUON_ASSERT_BREAK(m_slotCount + remaining - 1 <= ENTITY_INDEX_MASK, "Too many entities! (Max: %u)", ENTITY_INDEX_MASK);
+			const m::u32 pageCount = (m_slotCount + remaining + ENTITY_PAGE_SIZE - 1) / ENTITY_PAGE_SIZE;
+			m_pages->reserve(pageCount);
+			while (m_pages->size() < pageCount)
 			{
-				m_entities->erase(it);
-				break;
+				Entity* page = (Entity*)malloc(sizeof(Entity) * ENTITY_PAGE_SIZE);
+				MUON_ASSERT_BREAK(page != NULL, "Entity page can't be allocated!");
+				m_pages->push_back(page);
 			}
+			for (; created < count; ++created, ++m_slotCount)
+			{
+				out[created] = _getSlot(m_slotCount);
+				new (out[created]) Entity(makeEntityId(m_slotCount, 0));
+			}
+		}
+
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			out[i]->m_alive = true;
 		}
-		MUON_DELETE(e);
+		m_aliveCount += count;
 	}
 
-	void EntityManager::dispatchEntityHierarchyChange(Entity* entity, Entity* oldParent, Entity* newParent)
+	void EntityManager::destroy(Entity* e)
 	{
+		MUON_ASSERT(e != NULL && e->m_alive, "Destroying an invalid Entity!");
+		if (e == NULL || !e->m_alive)
+		{
+			return;
+		}
+
+		// Detach from the hierarchy, and release components
+		e->removeParent();
+		while (e->m_lastChild != NULL)
+		{
+			e->removeChild(e->m_lastChild);
+		}
+		e->_removeAllComponents();
+		m_archetypeStorage->removeEntity(e->m_id);
+
+		// Invalidate every existing id, then recycle the slot
+		m::u32 index = getEntityIndex(e->m_id);
+		e->m_id = makeEntityId(index, getEntityGeneration(e->m_id) + 1);
+		e->m_alive = false;
+		m_freeSlots->push_back(index);
+		--m_aliveCount;
+	}
+
+	void EntityManager::destroy(EntityId id)
+	{
+		if (Entity* e = get(id))
+		{
+			destroy(e);
+		}
+	}
+
+	bool EntityManager::isAlive(EntityId id) const
+	{
+		m::u32 index = getEntityIndex(id);
+		if (id == INVALID_ENTITY || index >= m_slotCount)
+		{
+			return false;
+		}
+		Entity* e = _getSlot(index);
+		return e->m_alive && e->m_id == id;
+	}
+
+	Entity* EntityManager::get(EntityId id) const
+	{
+		return (isAlive(id) ? _getSlot(getEntityIndex(id)) : NULL);
+	}
+
+	m::u32 EntityManager::getCount() const
+	{
+		return m_aliveCount;
+	}
+
+	m::u32 EntityManager::getSlotCount() const
+	{
+		return m_slotCount;
+	}
+
+	Entity* EntityManager::getFromSlot(m::u32 index) const
+	{
+		if (index >= m_slotCount)
+		{
+			return NULL;
+		}
+		Entity* e = _getSlot(index);
+		return (e->m_alive ? e : NULL);
+	}
+
+	void EntityManager::flushEvents()
+	{
+		if (m_hierarchyEvents->empty())
+		{
+			return;
+		}
+
 		auto& managerFactory = manager::ManagerFactory::getInstance();
 		for (m::u32 i = 0; i < managerFactory.getComponentManagerCount(); ++i)
 		{
-			managerFactory.getComponentManagerFromIndex(i)->onEntityHierarchyChanged(entity, oldParent, newParent);
+			manager::IBaseManager* manager = managerFactory.getComponentManagerFromIndex(i);
+			if (manager->getEventSubscriptions() & ENTITY_EVENT_HIERARCHY)
+			{
+				manager->onEntityHierarchyChanged(m_hierarchyEvents->data(), (m::u32)m_hierarchyEvents->size());
+			}
 		}
+		m_hierarchyEvents->clear();
+	}
+
+	ArchetypeStorage& EntityManager::getArchetypeStorage() const
+	{
+		return *m_archetypeStorage;
+	}
+
+	void EntityManager::dispatchEntityHierarchyChange(Entity* entity, Entity* oldParent, Entity* newParent)
+	{
+		MUON_ASSERT(system::JobSystem::getThreadIndex() == 0
+					, "Entity hierarchy can only change on the main thread, use a CommandBuffer on workers!");
+		HierarchyEvent e;
+		e.entity = entity->getId();
+		e.previousParent = (oldParent != NULL ? oldParent->getId() : INVALID_ENTITY);
+		e.newParent = (newParent != NULL ? newParent->getId() : INVALID_ENTITY);
+		m_hierarchyEvents->push_back(e);
 	}
 }
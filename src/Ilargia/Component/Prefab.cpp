@@ -0,0 +1,199 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <Muon/System/Assert.hpp>
+#include "Ilargia/Manager/ManagerFactory.hpp"
+#include "Ilargia/Component/Prefab.hpp"
+
+namespace ilg
+{
+	Prefab::Prefab()
+	{
+		typedef std::vector<m::u32> NodeList;
+		m_parents = MUON_NEW(NodeList);
+		m_columns = MUON_NEW(ColumnList);
+	}
+
+	Prefab::~Prefab()
+	{
+		MUON_DELETE(m_parents);
+		MUON_DELETE(m_columns);
+	}
+
+	m::u32 Prefab::addNode(m::u32 parent)
+	{
+		const m::u32 node = (m::u32)m_parents->size();
+		MUON_ASSERT(parent == PREFAB_NO_PARENT || parent < node, "Parent node %u doesn't exist!", parent);
+		m_parents->push_back(parent < node ? parent : PREFAB_NO_PARENT);
+		return node;
+	}
+
+	m::u32 Prefab::getNodeCount() const
+	{
+		return (m::u32)m_parents->size();
+	}
+
+	void Prefab::capture(const Entity* root)
+	{
+		clear();
+		if (root == NULL)
+		{
+			return;
+		}
+
+		auto& factory = manager::ManagerFactory::getInstance();
+		std::map<EntityId, m::u32> nodes;
+		for (const Entity* e = root; e != NULL; e = e->getNextInHierarchy(root))
+		{
+			// Depth-first: the parent has already been added
+			const m::u32 node = addNode(e != root ? nodes[e->getParent()->getId()] : PREFAB_NO_PARENT);
+			nodes[e->getId()] = node;
+
+			const ComponentMask& mask = e->getComponentMask();
+			for (m::u32 type = 0; type < factory.getComponentTypeCount(); ++type)
+			{
+				if (!mask.test(type))
+				{
+					continue;
+				}
+				manager::IBaseManager* manager = factory.getComponentManagerFromTypeIndex(type);
+				if (manager->isComponentSerializable())
+				{
+					_setComponent(type, node, manager->getComponent(e->_getComponent(type).getInstanceIndex()), manager->getComponentSize());
+				}
+			}
+		}
+	}
+
+	void Prefab::clear()
+	{
+		m_parents->clear();
+		m_columns->clear();
+	}
+
+	void Prefab::instantiate(m::u32 count, std::vector<Entity*>* created) const
+	{
+		const m::u32 nodeCount = getNodeCount();
+		if (count == 0 || nodeCount == 0)
+		{
+			return;
+		}
+
+		// Every Entity at once, then the hierarchy of each copy
+		std::vector<Entity*> entities(nodeCount * count);
+		EntityManager::getInstance().create(entities.data(), (m::u32)entities.size());
+		for (m::u32 copy = 0; copy < count; ++copy)
+		{
+			Entity** instance = &entities[copy * nodeCount];
+			for (m::u32 node = 0; node < nodeCount; ++node)
+			{
+				const m::u32 parent = (*m_parents)[node];
+				if (parent != PREFAB_NO_PARENT)
+				{
+					instance[node]->setParent(instance[parent]);
+				}
+			}
+		}
+
+		// Then each column: one bulk copy in the storage, one notification
+		std::vector<Entity*> targets;
+		std::vector<EntityId> owners;
+		std::vector<Component> handles;
+		for (auto it = m_columns->begin(); it != m_columns->end(); ++it)
+		{
+			const Column& column = *it;
+			const m::u32 columnSize = (m::u32)column.nodes.size();
+			const m::u32 total = columnSize * count;
+			targets.resize(total);
+			owners.resize(total);
+			handles.resize(total);
+			for (m::u32 copy = 0, i = 0; copy < count; ++copy)
+			{
+				for (m::u32 j = 0; j < columnSize; ++j, ++i)
+				{
+					targets[i] = entities[copy * nodeCount + column.nodes[j]];
+					owners[i] = targets[i]->getId();
+				}
+			}
+
+			column.manager->cloneComponents(column.data.data(), (m::i32)columnSize, (m::i32)count, owners.data(), handles.data());
+			for (m::u32 i = 0; i < total; ++i)
+			{
+				targets[i]->_bindComponent(handles[i]);
+			}
+			column.manager->onComponentsAdded(targets.data(), handles.data(), total);
+		}
+
+		if (created != NULL)
+		{
+			created->swap(entities);
+		}
+	}
+
+	bool Prefab::_setComponent(m::u32 typeIndex, m::u32 node, const void* value, m::u32 size)
+	{
+		MUON_ASSERT(node < getNodeCount(), "Node %u doesn't exist!", node);
+		manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManagerFromTypeIndex(typeIndex);
+		MUON_ASSERT(manager != NULL && manager->isComponentSerializable(), "Only trivially copyable components can be part of a Prefab!");
+		if (node >= getNodeCount() || manager == NULL || !manager->isComponentSerializable())
+		{
+			return false;
+		}
+		MUON_ASSERT(manager->getComponentSize() == size, "Component size mismatch!");
+
+		Column* column = NULL;
+		for (auto it = m_columns->begin(); it != m_columns->end() && column == NULL; ++it)
+		{
+			if (it->manager == manager)
+			{
+				column = &(*it);
+			}
+		}
+		if (column == NULL)
+		{
+			m_columns->push_back(Column());
+			column = &m_columns->back();
+			column->manager = manager;
+			column->elementSize = size;
+		}
+
+		// Keep nodes sorted, so each copy is laid out in node order in the storage
+		auto pos = std::lower_bound(column->nodes.begin(), column->nodes.end(), node);
+		const size_t offset = (size_t)(pos - column->nodes.begin()) * size;
+		if (pos == column->nodes.end() || *pos != node)
+		{
+			column->nodes.insert(pos, node);
+			column->data.insert(column->data.begin() + offset, size, 0);
+		}
+		memcpy(&column->data[offset], value, size);
+		return true;
+	}
+}
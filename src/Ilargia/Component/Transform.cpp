@@ -25,200 +25,707 @@
 *
 *************************************************************************/
 
+
+#include <algorithm>
 #include <Muon/System/Assert.hpp>
 
 #include "Ilargia/Manager/ManagerFactory.hpp"
+#include "Ilargia/System/JobSystem.hpp"
+#include "Ilargia/System/ParallelFor.hpp"
 #include "Ilargia/Component/Transform.hpp"
 
+namespace
+{
+	//! Below that many Transform to compute, dispatching jobs costs more than it saves
+	const m::u32 PARALLEL_MIN_TRANSFORMS = 4096;
+	//! Smallest work item, in Transform
+	const m::u32 PARALLEL_MIN_GRAIN = 512;
+	//! Each local change of the sorted list costs O(n): past that many in a frame, rebuild it
+	const m::u32 PATCH_MAX_CHANGES = 32;
+
+	//! Closest ancestor of an Entity having a Transform, or NULL
+	ilg::Entity* findTransformParent(ilg::Entity* entity)
+	{
+		ilg::Entity* parent = entity->getParent();
+		while (parent != NULL && !parent->hasComponent<ilg::Transform>())
+		{
+			parent = parent->getParent();
+		}
+		return parent;
+	}
+
+	//! Next Entity below root after the subtree of entity, or NULL
+	ilg::Entity* skipSubtree(ilg::Entity* entity, const ilg::Entity* root)
+	{
+		while (entity != root && entity != NULL)
+		{
+			if (entity->getNextSibling() != NULL)
+			{
+				return entity->getNextSibling();
+			}
+			entity = entity->getParent();
+		}
+		return NULL;
+	}
+
+	//! Apply remap to each queued dirty index, dropping the ones mapped to -1
+	template<typename Remap>
+	void remapDirtyIndices(std::vector<std::vector<m::i32> >& lists, Remap remap)
+	{
+		for (auto it = lists.begin(); it != lists.end(); ++it)
+		{
+			size_t kept = 0;
+			for (size_t i = 0; i < it->size(); ++i)
+			{
+				const m::i32 index = remap((*it)[i]);
+				if (index >= 0)
+				{
+					(*it)[kept++] = index;
+				}
+			}
+			it->resize(kept);
+		}
+	}
+}
+
 namespace ilg
 {
+	ILARGIA_COMPONENT_MANAGER_NAME(Transform)* Transform::s_manager = NULL;
+
 	Transform::Transform()
-		: position(0.f, 0.f, 0.f)
-		, scale(1.f, 1.f, 1.f)
-		, rotation(Quaternion::Identity)
-		, m_model(Matrix::Identity)
+		: m_position(0.f, 0.f, 0.f)
+		, m_scale(1.f, 1.f, 1.f)
+		, m_rotation(Quaternion::Identity)
+		, m_model(AffineMatrix::Identity)
+		, m_sortedIndex(-1)
+		, m_flags(TRANSFORM_WORLD_DIRTY)
 	{
 	}
 
-	Transform::~Transform()
+	Matrix Transform::getMatrix() const
 	{
+		return m_model.toMatrix();
 	}
 
-	Matrix Transform::getMatrix() const
+	void Transform::_queueDirty()
 	{
-		return m_model;
+		m_flags |= TRANSFORM_LOCAL_DIRTY | TRANSFORM_WORLD_DIRTY;
+		// Not sorted yet: the next update computes every matrix anyway
+		if (s_manager != NULL && m_sortedIndex >= 0)
+		{
+			m::u32 thread = system::JobSystem::getThreadIndex();
+			MUON_ASSERT_BREAK(thread < s_manager->m_dirtyTransforms->size(), "No dirty Transform list for thread %u!", thread);
+			(*s_manager->m_dirtyTransforms)[thread].push_back(m_sortedIndex);
+		}
 	}
 
 	ILARGIA_COMPONENT_MANAGER_NAME(Transform)::ILARGIA_COMPONENT_MANAGER_NAME(Transform)()
 		: IComponentManager(160)
 		, m_requireRootListUpdate(true)
-		, m_rootTransforms(NULL)
+		, m_storageSorted(false)
+		, m_patchCount(0)
 	{
+		typedef std::vector<Transform*> TransformList;
+		typedef std::vector<m::i32> IndexList;
+		typedef std::vector<m::u32> SizeList;
+		typedef std::vector<IndexList> ThreadIndexList;
+		typedef std::vector<TransformBatch> BatchList;
+		typedef std::vector<UpdateRange> RangeList;
+		m_sortedTransforms = MUON_NEW(TransformList);
+		m_parentIndices = MUON_NEW(IndexList);
+		m_rootTransforms = MUON_NEW(SizeList);
+		m_subtreeSizes = MUON_NEW(SizeList);
+		m_sortedIndices = MUON_NEW(IndexList);
+		// Usable before onInit(): a single list, for the main thread
+		m_dirtyTransforms = MUON_NEW(ThreadIndexList, 1);
+		m_dirtyIndices = MUON_NEW(IndexList);
+		m_subtreeStarts = MUON_NEW(IndexList);
+		m_nextStarts = MUON_NEW(IndexList);
+		m_ranges = MUON_NEW(RangeList);
+		m_batches = MUON_NEW(BatchList, 1);
+		m_stats = TransformUpdateStats();
+		Transform::s_manager = this;
 	}
 
 	ILARGIA_COMPONENT_MANAGER_NAME(Transform)::~ILARGIA_COMPONENT_MANAGER_NAME(Transform)()
 	{
+		MUON_DELETE(m_sortedTransforms);
+		MUON_DELETE(m_parentIndices);
+		MUON_DELETE(m_rootTransforms);
+		MUON_DELETE(m_subtreeSizes);
+		MUON_DELETE(m_sortedIndices);
+		MUON_DELETE(m_dirtyTransforms);
+		MUON_DELETE(m_dirtyIndices);
+		MUON_DELETE(m_subtreeStarts);
+		MUON_DELETE(m_nextStarts);
+		MUON_DELETE(m_ranges);
+		MUON_DELETE(m_batches);
+		if (Transform::s_manager == this)
+		{
+			Transform::s_manager = NULL;
+		}
 	}
 
 	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onInit()
 	{
-		/*
-		uint32_t chunk = 64;
-		Global::retrieve<uint32_t>("MEMCHUNK_TRANSFORM", &chunk);
-		m_components = new Array<Transform>(chunk);
-		m_rootTransforms = new Array<Component>(chunk);
-		Log::debug("[TRANSFORM] Initialized (%d)", chunk);
-		//*/
+		declareWrite<Transform>();
+		subscribe(ENTITY_EVENT_HIERARCHY);
+		// Initial capacity comes from "Storage" / "Capacity" / "Transform" in config.json
+		const m::u32 threadCount = system::JobSystem::getInstance().getWorkerCount() + 1;
+		m_dirtyTransforms->resize(threadCount);
+		m_batches->resize(threadCount);
 	}
 
 	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onUpdate(m::f32 dt)
 	{
-		/*
-		updateRootList();
-		for (auto it = m_rootTransforms->iterator(); it; ++it)
+		m_stats.rebuilt = m_requireRootListUpdate;
+		m_stats.updatedCount = 0;
+		m_stats.dirtySubtrees = 0;
+		m_stats.workItems = 0;
+		if (m_requireRootListUpdate)
+		{
+			// Pointers of the dirty lists may be stale: compute everything
+			updateRootList();
+			for (auto it = m_dirtyTransforms->begin(); it != m_dirtyTransforms->end(); ++it)
+			{
+				it->clear();
+			}
+			m_subtreeStarts->assign(m_rootTransforms->begin(), m_rootTransforms->end());
+			updateSubtrees();
+		}
+		else
 		{
-		//Fast retrieve of the Transform* from the Component
-		//(We don't go with it.value()->cast<>()...
-		updateRecursive(it.value());
+			updateDirtySubtrees();
 		}
-		//*/
+		m_stats.transformCount = (m::u32)m_sortedTransforms->size();
+		m_patchCount = 0;
 	}
 
 	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onTerm()
 	{
-		/*
-		if(m_components != NULL)
+		m_sortedTransforms->clear();
+		m_parentIndices->clear();
+		m_rootTransforms->clear();
+		m_subtreeSizes->clear();
+		m_sortedIndices->clear();
+		for (auto it = m_dirtyTransforms->begin(); it != m_dirtyTransforms->end(); ++it)
 		{
-		for(auto it = m_components->iterator(); it; ++it)
+			it->clear();
+		}
+		m_requireRootListUpdate = true;
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count)
+	{
+		if (count > PATCH_MAX_CHANGES)
 		{
-		it.value().~Transform();
+			m_requireRootListUpdate = true;
 		}
-		delete m_components;
-		m_components = NULL;
+
+		EntityManager& entities = EntityManager::getInstance();
+		for (m::u32 i = 0; i < count && !m_requireRootListUpdate; ++i)
+		{
+			// Destroyed since: its Transform was removed from the list already
+			Entity* entity = entities.get(events[i].entity);
+			if (entity == NULL)
+			{
+				continue;
+			}
+			// Without a Transform, the closest ones below the Entity get a new parent
+			if (entity->hasComponent<Transform>())
+			{
+				relinkTransform(entity);
+			}
+			else
+			{
+				relinkChildren(entity);
+			}
+		}
+	}
+
+	bool ILARGIA_COMPONENT_MANAGER_NAME(Transform)::canPatch()
+	{
+		if (m_requireRootListUpdate)
+		{
+			return false;
+		}
+		if (++m_patchCount > PATCH_MAX_CHANGES)
+		{
+			m_requireRootListUpdate = true;
+			return false;
+		}
+		return true;
+	}
+
+	Transform* ILARGIA_COMPONENT_MANAGER_NAME(Transform)::transformOf(Entity* entity) const
+	{
+		return &m_components->get(entity->getComponent<Transform>().getInstanceIndex());
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::appendTransform(Transform* transform)
+	{
+		transform->m_sortedIndex = (m::i32)m_sortedTransforms->size();
+		m_sortedTransforms->push_back(transform);
+		m_parentIndices->push_back(-1);
+		m_subtreeSizes->push_back(1);
+		transform->_queueDirty();
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::relinkTransform(Entity* entity)
+	{
+		Transform* transform = transformOf(entity);
+		if (transform->m_sortedIndex < 0)
+		{
+			return;
+		}
+		Entity* parentEntity = findTransformParent(entity);
+		const m::i32 parent = (parentEntity != NULL ? transformOf(parentEntity)->m_sortedIndex : -1);
+		if (parent != (*m_parentIndices)[transform->m_sortedIndex] && canPatch())
+		{
+			moveSubtree(transform->m_sortedIndex, parent);
+		}
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::relinkChildren(Entity* entity)
+	{
+		for (Entity* e = entity->getFirstChild(); e != NULL && !m_requireRootListUpdate;)
+		{
+			if (e->hasComponent<Transform>())
+			{
+				// Its own subtree moves along with it
+				relinkTransform(e);
+				e = skipSubtree(e, entity);
+			}
+			else
+			{
+				e = e->getNextInHierarchy(entity);
+			}
 		}
+	}
 
-		if(m_rootTransforms != NULL)
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::moveSubtree(m::i32 index, m::i32 parent)
+	{
+		std::vector<Transform*>& sorted = *m_sortedTransforms;
+		std::vector<m::i32>& parents = *m_parentIndices;
+		std::vector<m::u32>& sizes = *m_subtreeSizes;
+		const m::i32 count = (m::i32)sorted.size();
+		const m::i32 length = (m::i32)sizes[index];
+		// Last child of its new parent: right after the end of the parent subtree
+		const m::i32 target = (parent >= 0 ? parent + (m::i32)sizes[parent] : count);
+
+		for (m::i32 p = parents[index]; p >= 0; p = parents[p])
+		{
+			sizes[p] -= length;
+		}
+		for (m::i32 p = parent; p >= 0; p = parents[p])
+		{
+			sizes[p] += length;
+		}
+		parents[index] = parent;
+
+		// Rotate the subtree and the Transforms between it and the target
+		m::i32 begin = index;
+		m::i32 end = index;
+		m::i32 subtreeShift = 0;
+		m::i32 otherShift = 0;
+		if (target > index + length)
+		{
+			begin = index;
+			end = target;
+			subtreeShift = target - (index + length);
+			otherShift = -length;
+			std::rotate(sorted.begin() + index, sorted.begin() + index + length, sorted.begin() + target);
+			std::rotate(parents.begin() + index, parents.begin() + index + length, parents.begin() + target);
+			std::rotate(sizes.begin() + index, sizes.begin() + index + length, sizes.begin() + target);
+		}
+		else if (target < index)
+		{
+			begin = target;
+			end = index + length;
+			subtreeShift = target - index;
+			otherShift = length;
+			std::rotate(sorted.begin() + target, sorted.begin() + index, sorted.begin() + index + length);
+			std::rotate(parents.begin() + target, parents.begin() + index, parents.begin() + index + length);
+			std::rotate(sizes.begin() + target, sizes.begin() + index, sizes.begin() + index + length);
+		}
+
+		auto remap = [index, length, begin, end, subtreeShift, otherShift](m::i32 i)
+		{
+			if (i >= index && i < index + length)
+			{
+				return i + subtreeShift;
+			}
+			return (i >= begin && i < end ? i + otherShift : i);
+		};
+		// Transforms before begin have their parent before it too
+		for (m::i32 i = begin; i < count; ++i)
+		{
+			if (parents[i] >= 0)
+			{
+				parents[i] = remap(parents[i]);
+			}
+		}
+		for (m::i32 i = begin; i < end; ++i)
 		{
-		delete m_rootTransforms;
-		m_rootTransforms = NULL;
+			sorted[i]->m_sortedIndex = i;
 		}
-		//*/
+		remapDirtyIndices(*m_dirtyTransforms, remap);
+
+		// New parent, new world matrices for the whole subtree
+		sorted[remap(index)]->_queueDirty();
 	}
 
-	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onEntityHierarchyChanged(Entity* entity, Entity* previousParent, Entity* newParent)
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::eraseTransform(m::i32 index)
 	{
+		std::vector<Transform*>& sorted = *m_sortedTransforms;
+		std::vector<m::i32>& parents = *m_parentIndices;
+		std::vector<m::u32>& sizes = *m_subtreeSizes;
+		const m::i32 parent = parents[index];
+
+		for (m::i32 p = parent; p >= 0; p = parents[p])
+		{
+			--sizes[p];
+		}
+		// Its children stay in place, under its own parent now
+		for (m::i32 child = index + 1; child < index + (m::i32)sizes[index]; child += (m::i32)sizes[child])
+		{
+			parents[child] = parent;
+			sorted[child]->_queueDirty();
+		}
+
+		sorted[index]->m_sortedIndex = -1;
+		sorted.erase(sorted.begin() + index);
+		parents.erase(parents.begin() + index);
+		sizes.erase(sizes.begin() + index);
+
+		auto remap = [index](m::i32 i)
+		{
+			return (i == index ? -1 : (i > index ? i - 1 : i));
+		};
+		const m::i32 count = (m::i32)sorted.size();
+		for (m::i32 i = index; i < count; ++i)
+		{
+			if (parents[i] >= 0)
+			{
+				parents[i] = remap(parents[i]);
+			}
+			sorted[i]->m_sortedIndex = i;
+		}
+		remapDirtyIndices(*m_dirtyTransforms, remap);
 	}
 
 	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::updateRootList()
 	{
-		if (m_requireRootListUpdate)
+		if (!m_requireRootListUpdate)
+		{
+			return;
+		}
+		m_requireRootListUpdate = false;
+
+		EntityManager& entities = EntityManager::getInstance();
+		const m::i32 size = m_components->size();
+		m_sortedTransforms->clear();
+		m_parentIndices->clear();
+		m_rootTransforms->clear();
+		m_sortedTransforms->reserve(size);
+		m_parentIndices->reserve(size);
+		m_sortedIndices->assign(size, -1);
+
+		auto append = [this](m::i32 pos, m::i32 parent)
+		{
+			Transform* t = &m_components->getDense(pos);
+			t->m_sortedIndex = (m::i32)m_sortedTransforms->size();
+			(*m_sortedIndices)[pos] = t->m_sortedIndex;
+			m_sortedTransforms->push_back(t);
+			m_parentIndices->push_back(parent);
+		};
+		auto positionOf = [this](Entity* entity)
 		{
-			/*
-			//Recreate the whole list
-			m::i32 transform_type = type_id<Transform>();
-			m_rootTransforms->clear();
-			for (auto it = m_components->iterator(); it; ++it)
+			return m_components->getPosition(entity->getComponent<Transform>().getInstanceIndex());
+		};
+
+		// Walk the subtree of each root depth-first, so parents always come first
+		for (m::i32 pos = 0; pos < size; ++pos)
+		{
+			Entity* root = entities.get(m_components->getOwner(pos));
+			if (root == NULL)
+			{
+				// Not given to any Entity yet: nothing depends on it
+				m_rootTransforms->push_back((m::u32)m_sortedTransforms->size());
+				append(pos, -1);
+				continue;
+			}
+			if (findTransformParent(root) != NULL)
 			{
-			Transform& t = it.value();
-			//Only had if the Transform have no valid parent
-			if (!t._parent.isValid())
+				continue;
+			}
+
+			m_rootTransforms->push_back((m::u32)m_sortedTransforms->size());
+			append(pos, -1);
+			for (Entity* e = root->getFirstChild(); e != NULL; e = e->getNextInHierarchy(root))
 			{
-			m_rootTransforms->add(makeComponent(it.index(), transform_type));
+				if (e->hasComponent<Transform>())
+				{
+					append(positionOf(e), (*m_sortedIndices)[positionOf(findTransformParent(e))]);
+				}
 			}
+		}
+		MUON_ASSERT(m_sortedTransforms->size() == (size_t)size, "Some Transform are missing from the sorted list!");
+
+		// Opt-in, see setStorageSorted(): store the Transforms in sorted order, so the
+		// update pass reads the pages linearly. Each swap puts one Transform in place
+		if (m_storageSorted)
+		{
+			for (m::i32 pos = 0; pos < size; ++pos)
+			{
+				while (m_components->getDense(pos).m_sortedIndex != pos)
+				{
+					m_components->swapDense(pos, m_components->getDense(pos).m_sortedIndex);
+				}
+				(*m_sortedTransforms)[pos] = &m_components->getDense(pos);
+			}
+		}
+
+		// Children come after their parent: accumulate sizes backward
+		const m::i32* parents = m_parentIndices->data();
+		m_subtreeSizes->assign(m_sortedTransforms->size(), 1);
+		m::u32* sizes = m_subtreeSizes->data();
+		for (m::i32 i = (m::i32)m_sortedTransforms->size() - 1; i > 0; --i)
+		{
+			if (parents[i] >= 0)
+			{
+				sizes[parents[i]] += sizes[i];
 			}
-			//*/
 		}
 	}
 
-	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::updateRecursive(Component& component)
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::updateWorldMatrices(m::i32 begin, m::i32 end)
 	{
-		/*
-		Transform* transform = &(*m_components)[component.getID()];
-		//Check for a Destroy flag
-		if(transform->flags & ObjectType::REQUIRE_DELETE)
+		// Parents come first: they are computed by a previous batch, or earlier in the same one
+		Transform* const* sorted = m_sortedTransforms->data();
+		const m::i32* parents = m_parentIndices->data();
+		m::u32 thread = system::JobSystem::getThreadIndex();
+		MUON_ASSERT_BREAK(thread < m_batches->size(), "No TransformBatch for thread %u!", thread);
+		TransformBatch& batch = (*m_batches)[thread];
+		for (m::i32 i = begin; i < end; ++i)
 		{
-		destroy(component);
-		rootListChanged();
+			Transform* t = sorted[i];
+			const AffineMatrix* parent = (parents[i] >= 0 ? &sorted[parents[i]]->m_model : &AffineMatrix::Identity);
+			batch.push(t->m_position, t->m_rotation, t->m_scale, parent, &t->m_model);
+			t->m_flags = 0;
+			if (batch.isFull())
+			{
+				composeTransforms(batch);
+			}
 		}
-		else
+		if (batch.count > 0)
 		{
-		//Update itself
-		if(transform->_parent.getID() == INVALID_INDEX)
+			composeTransforms(batch);
+		}
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::updateDirtySubtrees()
+	{
+		m_dirtyIndices->clear();
+		for (auto it = m_dirtyTransforms->begin(); it != m_dirtyTransforms->end(); ++it)
 		{
-		transform->_model = Matrix::identity;
+			m_dirtyIndices->insert(m_dirtyIndices->end(), it->begin(), it->end());
+			it->clear();
 		}
-		else
+		if (m_dirtyIndices->empty())
 		{
-		transform->_model = (*m_components)[transform->_parent.getID()]._model;
+			return;
 		}
 
-		transform->_model = transform->_model.translate(transform->position);
-		transform->_model = transform->_model.rotate(transform->rotation);
-		transform->_model = transform->_model.scale(transform->scale);
+		// A subtree is contiguous: skip the dirty Transform already covered by a dirty ancestor
+		std::sort(m_dirtyIndices->begin(), m_dirtyIndices->end());
+		const m::u32* sizes = m_subtreeSizes->data();
+		const m::i32 count = (m::i32)m_sortedTransforms->size();
+		m::i32 end = 0;
+		m_subtreeStarts->clear();
+		for (auto it = m_dirtyIndices->begin(); it != m_dirtyIndices->end() && *it < count; ++it)
+		{
+			if (*it < end)
+			{
+				continue;
+			}
+			end = *it + (m::i32)sizes[*it];
+			m_subtreeStarts->push_back(*it);
+		}
+		updateSubtrees();
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::updateSubtrees()
+	{
+		const m::u32* sizes = m_subtreeSizes->data();
+		m::u32 total = 0;
+		for (auto it = m_subtreeStarts->begin(); it != m_subtreeStarts->end(); ++it)
+		{
+			total += sizes[*it];
 		}
+		m_stats.updatedCount += total;
+		m_stats.dirtySubtrees += (m::u32)m_subtreeStarts->size();
 
-		//Update next child
-		for(auto it = transform->_children->iterator(); it; ++it)
+		const m::u32 threadCount = (m::u32)m_batches->size();
+		if (threadCount == 1 || total < PARALLEL_MIN_TRANSFORMS)
 		{
-		updateRecursive(it.value());
+			for (auto it = m_subtreeStarts->begin(); it != m_subtreeStarts->end(); ++it)
+			{
+				updateWorldMatrices(*it, *it + (m::i32)sizes[*it]);
+			}
+			m_stats.workItems += (m::u32)m_subtreeStarts->size();
+			return;
+		}
+
+		// About 4 work items per thread, so uneven ones still balance out
+		const m::u32 grain = std::max(total / (threadCount * 4), PARALLEL_MIN_GRAIN);
+		while (!m_subtreeStarts->empty())
+		{
+			// Subtrees of a level are independent: group them in work items of about grain
+			// Transform. One bigger than that only has its root computed here, its children
+			// subtrees make the next level, once the whole level is done.
+			m::i32* starts = m_subtreeStarts->data();
+			const m::i32 startCount = (m::i32)m_subtreeStarts->size();
+			m::i32 kept = 0;
+			m::u32 itemSize = 0;
+			m_nextStarts->clear();
+			m_ranges->clear();
+			for (m::i32 i = 0; i < startCount; ++i)
+			{
+				const m::i32 start = starts[i];
+				const m::u32 size = sizes[start];
+				if (size > grain)
+				{
+					updateWorldMatrices(start, start + 1);
+					for (m::i32 child = start + 1; child < start + (m::i32)size; child += (m::i32)sizes[child])
+					{
+						m_nextStarts->push_back(child);
+					}
+					continue;
+				}
+				if (m_ranges->empty() || itemSize + size > grain)
+				{
+					UpdateRange range = { kept, kept };
+					m_ranges->push_back(range);
+					itemSize = 0;
+				}
+				starts[kept++] = start;
+				m_ranges->back().end = kept;
+				itemSize += size;
+			}
+
+			const UpdateRange* ranges = m_ranges->data();
+			system::parallelFor((m::i32)m_ranges->size(), 1, [this, starts, sizes, ranges](m::i32 begin, m::i32 end)
+			{
+				for (m::i32 r = begin; r < end; ++r)
+				{
+					// Sibling subtrees are often contiguous: compute them in one call
+					m::i32 first = starts[ranges[r].begin];
+					m::i32 last = first;
+					for (m::i32 i = ranges[r].begin; i < ranges[r].end; ++i)
+					{
+						if (starts[i] != last)
+						{
+							updateWorldMatrices(first, last);
+							first = starts[i];
+						}
+						last = starts[i] + (m::i32)sizes[starts[i]];
+					}
+					updateWorldMatrices(first, last);
+				}
+			});
+			m_stats.workItems += (m::u32)m_ranges->size();
+			std::swap(m_subtreeStarts, m_nextStarts);
 		}
-		//*/
 	}
 
-	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onComponentAdded(Entity* entity, Component& component)
+	const TransformUpdateStats& ILARGIA_COMPONENT_MANAGER_NAME(Transform)::getUpdateStats() const
 	{
-		/*
-		Transform* t = component;
+		return m_stats;
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::setStorageSorted(bool sorted)
+	{
+		// Sorted from the next update on
+		if (sorted && !m_storageSorted)
+		{
+			m_requireRootListUpdate = true;
+		}
+		m_storageSorted = sorted;
+	}
 
-		uint32_t chunk = 8;
-		Global::retrieve<uint32_t>("MEMCHUNK_TRANSFORM_CHILDREN", &chunk);
-		m_rootTransforms->add(component);
-		//*/
+	bool ILARGIA_COMPONENT_MANAGER_NAME(Transform)::isStorageSorted() const
+	{
+		return m_storageSorted;
 	}
 
-	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onComponentRemoved(Entity* entity, Component& component)
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onComponentAdded(Entity* entity, Component& component)
 	{
-		/*
-		for(auto it = m_rootTransforms->iterator(); it; ++it)
+		if (m_requireRootListUpdate)
+		{
+			return;
+		}
+		// Loaded or cloned Transforms were not created here: not sorted yet
+		Transform* transform = &m_components->get(component.getInstanceIndex());
+		if (transform->m_sortedIndex < 0)
 		{
-		Component c = it.value();
-		if(c == component)
+			appendTransform(transform);
+		}
+		// Its parent may have one already, and the closest Transforms below now have it as parent
+		relinkTransform(entity);
+		relinkChildren(entity);
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onComponentsAdded(Entity* const* entities, Component* components, m::u32 count)
+	{
+		if (count > PATCH_MAX_CHANGES)
 		{
-		Transform* t = component;
-		t->flags |= ObjectType::REQUIRE_DELETE;
-		return;
+			m_requireRootListUpdate = true;
+			return;
 		}
+		for (m::u32 i = 0; i < count; ++i)
+		{
+			onComponentAdded(entities[i], components[i]);
 		}
-		//*/
+	}
+
+	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::onComponentLoaded(Transform& component)
+	{
+		component.m_sortedIndex = -1;
+		component.m_flags = TRANSFORM_LOCAL_DIRTY | TRANSFORM_WORLD_DIRTY;
 	}
 
 	Component ILARGIA_COMPONENT_MANAGER_NAME(Transform)::createComponent()
 	{
-		return setupComponent<Transform>(m_components->add());
+		// A root until given to an Entity, see onComponentAdded()
+		const m::i32 index = m_components->add();
+		if (!m_requireRootListUpdate)
+		{
+			appendTransform(&m_components->get(index));
+		}
+		return setupComponent<Transform>(index);
 	}
 
 	void ILARGIA_COMPONENT_MANAGER_NAME(Transform)::destroyComponent(Component& component)
 	{
-		//m::i32 i = component.getInstanceIndex();
-		//_components->remove(i);
-		/*
-		MUON_ASSERT(component.isValid()
-		, "[MODULE] (%s) Trying to destroy an Invalid Component!"
-		, _name);
-		if(Transform* ptr = component)
-		{
-		//Make its children have a new parent
-		for(auto it = ptr->_children->iterator(); it; ++it)
+		const m::i32 index = component.getInstanceIndex();
+		const m::i32 pos = m_components->getPosition(index);
+		const m::i32 sortedIndex = m_components->get(index).m_sortedIndex;
+		if (sortedIndex >= 0 && canPatch())
 		{
-		(*m_components)[it.index()]._parent = makeComponent();
+			eraseTransform(sortedIndex);
 		}
-		m_components->remove(component);
-		ptr->Transform::~Transform();
-		//Invalidate the component
-		component = makeComponent();
-		ptr->_parent = component;
+
+		// The last Transform is moved in place of the removed one
+		m_components->remove(index);
+		if (!m_requireRootListUpdate && pos < m_components->size())
+		{
+			Transform* moved = &m_components->getDense(pos);
+			if (moved->m_sortedIndex >= 0)
+			{
+				(*m_sortedTransforms)[moved->m_sortedIndex] = moved;
+			}
 		}
-		//*/
 	}
 
 	void* ILARGIA_COMPONENT_MANAGER_NAME(Transform)::getComponent(m::i32 index)
@@ -228,12 +735,10 @@ namespace ilg
 
 	Component ILARGIA_COMPONENT_MANAGER_NAME(Transform)::getComponent(void* object)
 	{
-		for (m::i32 i = 0; i < m_components->size(); ++i)
+		m::i32 pos = m_components->getPosition((Transform*)object);
+		if (pos != m::INVALID_INDEX)
 		{
-			if (object == &(m_components->get(i)))
-			{
-				return setupComponent<Transform>(i);
-			}
+			return setupComponent<Transform>(m_components->getIndex(pos));
 		}
 		return Component();
 	}
@@ -0,0 +1,339 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <Muon/System/Log.hpp>
+#include "Ilargia/Manager/ManagerFactory.hpp"
+#include "Ilargia/Component/WorldSnapshot.hpp"
+
+namespace
+{
+	m::u64 alignOffset(m::u64 offset)
+	{
+		const m::u64 align = ilg::WorldSnapshot::SNAPSHOT_ALIGNMENT;
+		return (offset + align - 1) / align * align;
+	}
+
+	//! Return true if [offset, offset + bytes) is within size, without overflowing
+	bool fitsIn(m::u64 offset, m::u64 bytes, m::u64 size)
+	{
+		return offset <= size && bytes <= size - offset;
+	}
+
+	void writePadding(std::ofstream& file, m::u64 offset)
+	{
+		static const char zeros[ilg::WorldSnapshot::SNAPSHOT_ALIGNMENT] = { 0 };
+		const m::u64 padding = alignOffset(offset) - offset;
+		file.write(zeros, (std::streamsize)padding);
+	}
+}
+
+namespace ilg
+{
+	bool WorldSnapshot::save(const m::String& filename)
+	{
+		m::system::Log log("SNAPSHOT");
+		EntityManager& entities = EntityManager::getInstance();
+		auto& factory = manager::ManagerFactory::getInstance();
+
+		// Number entities depth-first from each root, so parents come first
+		const m::u32 slotCount = entities.getSlotCount();
+		std::vector<m::u32> indices(slotCount, SNAPSHOT_NO_PARENT);
+		std::vector<m::u32> parents;
+		parents.reserve(entities.getCount());
+		for (m::u32 slot = 0; slot < slotCount; ++slot)
+		{
+			Entity* root = entities.getFromSlot(slot);
+			if (root == NULL || root->getParent() != NULL)
+			{
+				continue;
+			}
+			for (Entity* e = root; e != NULL; e = e->getNextInHierarchy(root))
+			{
+				indices[getEntityIndex(e->getId())] = (m::u32)parents.size();
+				parents.push_back(e->getParent() != NULL ? indices[getEntityIndex(e->getParent()->getId())] : SNAPSHOT_NO_PARENT);
+			}
+		}
+
+		// Gather the components of every serializable type, dropping the ones without a living owner
+		std::vector<SnapshotColumn> columns;
+		std::vector<std::vector<m::u32> > owners;
+		std::vector<std::vector<m::u8> > data;
+		for (m::u32 i = 0; i < factory.getComponentTypeCount(); ++i)
+		{
+			const manager::ComponentTypeInfo& info = factory.getComponentTypeInfo(i);
+			manager::IBaseManager* manager = info.manager;
+			const m::i32 size = manager->getStats().size;
+			if (size == 0)
+			{
+				continue;
+			}
+			if (!manager->isComponentSerializable())
+			{
+				log(m::LOG_WARNING) << "Skipping \"" << info.name << "\": Component is not trivially copyable" << m::endl;
+				continue;
+			}
+
+			const m::u32 elementSize = manager->getComponentSize();
+			std::vector<m::u8> bytes((size_t)size * elementSize);
+			std::vector<EntityId> storageOwners(size);
+			std::vector<m::u32> columnOwners;
+			columnOwners.reserve(size);
+			manager->copyComponents(bytes.data(), storageOwners.data());
+
+			m::u32 count = 0;
+			for (m::i32 pos = 0; pos < size; ++pos)
+			{
+				const EntityId owner = storageOwners[pos];
+				if (!entities.isAlive(owner))
+				{
+					continue;
+				}
+				if ((m::u32)pos != count)
+				{
+					memcpy(&bytes[count * elementSize], &bytes[pos * elementSize], elementSize);
+				}
+				columnOwners.push_back(indices[getEntityIndex(owner)]);
+				++count;
+			}
+			bytes.resize((size_t)count * elementSize);
+
+			SnapshotColumn column = { info.id, elementSize, count, 0, 0 };
+			columns.push_back(column);
+			owners.push_back(columnOwners);
+			data.push_back(bytes);
+		}
+
+		// Compute the layout, then write everything in one pass
+		SnapshotHeader header;
+		header.magic = SNAPSHOT_MAGIC;
+		header.version = SNAPSHOT_VERSION;
+		header.entityCount = (m::u32)parents.size();
+		header.columnCount = (m::u32)columns.size();
+		header.parentsOffset = sizeof(SnapshotHeader);
+		header.columnsOffset = alignOffset(header.parentsOffset + sizeof(m::u32) * parents.size());
+		m::u64 offset = header.columnsOffset + sizeof(SnapshotColumn) * columns.size();
+		for (size_t i = 0; i < columns.size(); ++i)
+		{
+			columns[i].ownersOffset = alignOffset(offset);
+			columns[i].dataOffset = alignOffset(columns[i].ownersOffset + sizeof(m::u32) * columns[i].count);
+			offset = columns[i].dataOffset + (m::u64)columns[i].elementSize * columns[i].count;
+		}
+
+		std::ofstream file(filename.cStr(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			log(m::LOG_ERROR) << "Couldn't open \"" << filename << "\" for writing" << m::endl;
+			return false;
+		}
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)parents.data(), sizeof(m::u32) * parents.size());
+		writePadding(file, header.parentsOffset + sizeof(m::u32) * parents.size());
+		file.write((const char*)columns.data(), sizeof(SnapshotColumn) * columns.size());
+		offset = header.columnsOffset + sizeof(SnapshotColumn) * columns.size();
+		for (size_t i = 0; i < columns.size(); ++i)
+		{
+			writePadding(file, offset);
+			file.write((const char*)owners[i].data(), sizeof(m::u32) * owners[i].size());
+			writePadding(file, columns[i].ownersOffset + sizeof(m::u32) * columns[i].count);
+			file.write((const char*)data[i].data(), data[i].size());
+			offset = columns[i].dataOffset + data[i].size();
+		}
+		return file.good();
+	}
+
+	WorldSnapshot::WorldSnapshot()
+		: m_header(NULL)
+	{
+	}
+
+	WorldSnapshot::~WorldSnapshot()
+	{
+		close();
+	}
+
+	bool WorldSnapshot::open(const m::String& filename)
+	{
+		m::system::Log log("SNAPSHOT");
+		close();
+		if (!m_file.open(filename))
+		{
+			log(m::LOG_ERROR) << "Couldn't map \"" << filename << "\"" << m::endl;
+			return false;
+		}
+
+		// Check every offset and owner before trusting the file.
+		// Sizes are compared with what remains after each offset: a huge offset can't wrap around
+		const m::u64 size = m_file.size();
+		const SnapshotHeader* header = (const SnapshotHeader*)m_file.data();
+		bool valid = size >= sizeof(SnapshotHeader)
+			&& header->magic == SNAPSHOT_MAGIC
+			&& header->version == SNAPSHOT_VERSION
+			&& fitsIn(header->parentsOffset, sizeof(m::u32) * (m::u64)header->entityCount, size)
+			&& fitsIn(header->columnsOffset, sizeof(SnapshotColumn) * (m::u64)header->columnCount, size);
+		for (m::u32 i = 0; valid && i < header->columnCount; ++i)
+		{
+			const SnapshotColumn& column = ((const SnapshotColumn*)(m_file.data() + header->columnsOffset))[i];
+			valid = fitsIn(column.ownersOffset, sizeof(m::u32) * (m::u64)column.count, size)
+				&& fitsIn(column.dataOffset, (m::u64)column.elementSize * column.count, size);
+
+			const m::u32* owners = (const m::u32*)(m_file.data() + column.ownersOffset);
+			for (m::u32 j = 0; valid && j < column.count; ++j)
+			{
+				valid = owners[j] < header->entityCount;
+			}
+		}
+		if (!valid)
+		{
+			log(m::LOG_ERROR) << "\"" << filename << "\" is not a valid snapshot (version " << SNAPSHOT_VERSION << ")" << m::endl;
+			m_file.close();
+			return false;
+		}
+		m_header = header;
+		return true;
+	}
+
+	void WorldSnapshot::close()
+	{
+		m_file.close();
+		m_header = NULL;
+	}
+
+	bool WorldSnapshot::isOpen() const
+	{
+		return m_header != NULL;
+	}
+
+	void WorldSnapshot::prefetch() const
+	{
+		m_file.prefetch();
+	}
+
+	m::u32 WorldSnapshot::getEntityCount() const
+	{
+		return (m_header != NULL ? m_header->entityCount : 0);
+	}
+
+	const m::u32* WorldSnapshot::getParents() const
+	{
+		return (const m::u32*)(m_file.data() + m_header->parentsOffset);
+	}
+
+	m::u32 WorldSnapshot::getColumnCount() const
+	{
+		return (m_header != NULL ? m_header->columnCount : 0);
+	}
+
+	const SnapshotColumn& WorldSnapshot::getColumn(m::u32 column) const
+	{
+		MUON_ASSERT(column < getColumnCount(), "No column at index %u!", column);
+		return ((const SnapshotColumn*)(m_file.data() + m_header->columnsOffset))[column];
+	}
+
+	const m::u32* WorldSnapshot::getColumnOwners(m::u32 column) const
+	{
+		return (const m::u32*)(m_file.data() + getColumn(column).ownersOffset);
+	}
+
+	const void* WorldSnapshot::getColumnData(m::u32 column) const
+	{
+		return m_file.data() + getColumn(column).dataOffset;
+	}
+
+	manager::IBaseManager* WorldSnapshot::getColumnManager(m::u32 c) const
+	{
+		const SnapshotColumn& column = getColumn(c);
+		manager::IBaseManager* manager = manager::ManagerFactory::getInstance().getComponentManager(column.type);
+		if (manager == NULL || !manager->isComponentSerializable() || manager->getComponentSize() != column.elementSize)
+		{
+			return NULL;
+		}
+		return manager;
+	}
+
+	bool WorldSnapshot::instantiate(std::vector<Entity*>* created) const
+	{
+		if (!isOpen())
+		{
+			return false;
+		}
+
+		m::system::Log log("SNAPSHOT");
+		EntityManager& entities = EntityManager::getInstance();
+
+		// Entities, then hierarchy: parents are always created before their children
+		const m::u32 entityCount = getEntityCount();
+		const m::u32* parents = getParents();
+		std::vector<Entity*> local(entityCount);
+		entities.create(local.data(), entityCount);
+		for (m::u32 i = 0; i < entityCount; ++i)
+		{
+			if (parents[i] != SNAPSHOT_NO_PARENT && parents[i] < i)
+			{
+				local[i]->setParent(local[parents[i]]);
+			}
+		}
+
+		// Components, one column at a time: one bulk copy in the storage, one notification
+		std::vector<Entity*> targets;
+		std::vector<EntityId> ownerIds;
+		std::vector<Component> handles;
+		for (m::u32 c = 0; c < getColumnCount(); ++c)
+		{
+			const SnapshotColumn& column = getColumn(c);
+			manager::IBaseManager* manager = getColumnManager(c);
+			if (manager == NULL)
+			{
+				log(m::LOG_WARNING) << "Skipping a column of " << column.count << " components: no matching manager" << m::endl;
+				continue;
+			}
+
+			const m::u32* owners = getColumnOwners(c);
+			targets.resize(column.count);
+			ownerIds.resize(column.count);
+			handles.resize(column.count);
+			for (m::u32 i = 0; i < column.count; ++i)
+			{
+				targets[i] = local[owners[i]];
+				ownerIds[i] = targets[i]->getId();
+			}
+			manager->loadComponents(getColumnData(c), (m::i32)column.count, ownerIds.data(), handles.data());
+			for (m::u32 i = 0; i < column.count; ++i)
+			{
+				targets[i]->_bindComponent(handles[i]);
+			}
+			manager->onComponentsAdded(targets.data(), handles.data(), column.count);
+		}
+
+		if (created != NULL)
+		{
+			created->swap(local);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,461 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include <algorithm>
+#include <chrono>
+#include <Muon/System/Assert.hpp>
+#include <Muon/System/Log.hpp>
+#include "Ilargia/Manager/IBaseManager.hpp"
+#include "Ilargia/Component/WorldStreamer.hpp"
+
+namespace ilg
+{
+	WorldStreamer::WorldStreamer()
+		: m_loader(NULL)
+		, m_running(false)
+		, m_nextId(INVALID_STREAM + 1)
+		, m_timeBudget(1.f)
+	{
+		m_sections = MUON_NEW(SectionList);
+	}
+
+	WorldStreamer::~WorldStreamer()
+	{
+		term();
+		MUON_DELETE(m_sections);
+	}
+
+	void WorldStreamer::init()
+	{
+		MUON_ASSERT(m_loader == NULL, "WorldStreamer is already initialized!");
+		if (m_loader != NULL)
+		{
+			return;
+		}
+		m_running = true;
+		m_loader = MUON_NEW(std::thread, [this]() { _loaderLoop(); });
+	}
+
+	void WorldStreamer::term()
+	{
+		if (m_loader != NULL)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_running = false;
+			}
+			m_condition.notify_all();
+			m_loader->join();
+			MUON_DELETE(m_loader);
+			m_loader = NULL;
+		}
+
+		for (auto it = m_sections->begin(); it != m_sections->end(); ++it)
+		{
+			MUON_DELETE(*it);
+		}
+		m_sections->clear();
+	}
+
+	StreamId WorldStreamer::load(const m::String& filename, m::i32 priority)
+	{
+		Section* section = MUON_NEW(Section);
+		section->filename = filename;
+		section->priority = priority;
+		section->state = STREAM_QUEUED;
+		section->cancelled = false;
+		section->step = STEP_ENTITIES;
+		section->column = 0;
+		section->cursor = 0;
+		section->done = 0;
+		section->total = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			section->id = m_nextId++;
+			m_sections->push_back(section);
+		}
+		m_condition.notify_one();
+		return section->id;
+	}
+
+	bool WorldStreamer::cancel(StreamId id)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Section* section = _find(id);
+		if (section == NULL)
+		{
+			return false;
+		}
+
+		switch (section->state)
+		{
+			case STREAM_QUEUED:
+				section->state = STREAM_CANCELLED;
+				return true;
+			case STREAM_LOADING:
+				// The loader thread owns it until the load ends
+				section->cancelled = true;
+				return true;
+			case STREAM_STAGED:
+				section->snapshot.close();
+				section->state = STREAM_CANCELLED;
+				return true;
+			case STREAM_INTEGRATING:
+				_rollback(section);
+				section->state = STREAM_CANCELLED;
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	void WorldStreamer::setPriority(StreamId id, m::i32 priority)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (Section* section = _find(id))
+		{
+			section->priority = priority;
+		}
+	}
+
+	StreamState WorldStreamer::getState(StreamId id) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Section* section = _find(id);
+		return (section != NULL ? section->state : STREAM_NONE);
+	}
+
+	m::f32 WorldStreamer::getProgress(StreamId id) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Section* section = _find(id);
+		if (section == NULL)
+		{
+			return 0.f;
+		}
+		if (section->state == STREAM_DONE)
+		{
+			return 1.f;
+		}
+		return (section->total > 0 ? (m::f32)section->done / section->total : 0.f);
+	}
+
+	const std::vector<Entity*>* WorldStreamer::getEntities(StreamId id) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Section* section = _find(id);
+		return (section != NULL && section->state == STREAM_DONE ? &section->entities : NULL);
+	}
+
+	bool WorldStreamer::release(StreamId id)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_sections->begin(); it != m_sections->end(); ++it)
+		{
+			Section* section = *it;
+			if (section->id == id)
+			{
+				if (section->state != STREAM_DONE
+					&& section->state != STREAM_CANCELLED
+					&& section->state != STREAM_FAILED)
+				{
+					return false;
+				}
+				MUON_DELETE(section);
+				m_sections->erase(it);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void WorldStreamer::setTimeBudget(m::f32 milliseconds)
+	{
+		m_timeBudget = milliseconds;
+	}
+
+	m::f32 WorldStreamer::getTimeBudget() const
+	{
+		return m_timeBudget;
+	}
+
+	void WorldStreamer::integrate()
+	{
+		typedef std::chrono::steady_clock Clock;
+		const Clock::time_point start = Clock::now();
+		const Clock::duration budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<m::f32, std::milli>(m_timeBudget));
+
+		bool timeLeft = true;
+		while (timeLeft)
+		{
+			Section* section = NULL;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				section = _nextToIntegrate();
+				if (section == NULL)
+				{
+					return;
+				}
+				section->state = STREAM_INTEGRATING;
+			}
+
+			// Always do at least one batch, so a section progresses whatever the budget
+			bool finished = false;
+			do
+			{
+				finished = _integrateBatch(section);
+				timeLeft = (Clock::now() - start < budget);
+			}
+			while (!finished && timeLeft);
+
+			if (finished)
+			{
+				section->snapshot.close();
+				section->managers.clear();
+				std::vector<Component>().swap(section->components);
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				section->state = STREAM_DONE;
+			}
+		}
+	}
+
+	WorldStreamer::Section* WorldStreamer::_find(StreamId id) const
+	{
+		for (auto it = m_sections->begin(); it != m_sections->end(); ++it)
+		{
+			if ((*it)->id == id)
+			{
+				return *it;
+			}
+		}
+		return NULL;
+	}
+
+	WorldStreamer::Section* WorldStreamer::_nextToLoad() const
+	{
+		// Highest priority first, then in load() order
+		Section* next = NULL;
+		for (auto it = m_sections->begin(); it != m_sections->end(); ++it)
+		{
+			Section* section = *it;
+			if (section->state == STREAM_QUEUED && (next == NULL || section->priority > next->priority))
+			{
+				next = section;
+			}
+		}
+		return next;
+	}
+
+	WorldStreamer::Section* WorldStreamer::_nextToIntegrate() const
+	{
+		Section* next = NULL;
+		for (auto it = m_sections->begin(); it != m_sections->end(); ++it)
+		{
+			Section* section = *it;
+			if ((section->state == STREAM_STAGED || section->state == STREAM_INTEGRATING)
+				&& (next == NULL || section->priority > next->priority))
+			{
+				next = section;
+			}
+		}
+		return next;
+	}
+
+	void WorldStreamer::_loaderLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			Section* section = NULL;
+			m_condition.wait(lock, [this, &section]()
+			{
+				return !m_running || (section = _nextToLoad()) != NULL;
+			});
+			if (!m_running)
+			{
+				return;
+			}
+
+			section->state = STREAM_LOADING;
+			lock.unlock();
+			const bool staged = _stage(section);
+			lock.lock();
+
+			if (section->cancelled)
+			{
+				section->snapshot.close();
+				section->state = STREAM_CANCELLED;
+			}
+			else
+			{
+				section->state = (staged ? STREAM_STAGED : STREAM_FAILED);
+			}
+		}
+	}
+
+	bool WorldStreamer::_stage(Section* section)
+	{
+		m::system::Log log("STREAMER");
+		WorldSnapshot& snapshot = section->snapshot;
+		if (!snapshot.open(section->filename))
+		{
+			return false;
+		}
+
+		// Managers are all registered before the loop starts, looking them up here is safe
+		const m::u32 entityCount = snapshot.getEntityCount();
+		section->total = entityCount * 2;
+		section->managers.resize(snapshot.getColumnCount());
+		for (m::u32 c = 0; c < snapshot.getColumnCount() && !section->cancelled; ++c)
+		{
+			// Owners are checked by WorldSnapshot::open()
+			const SnapshotColumn& column = snapshot.getColumn(c);
+			section->managers[c] = snapshot.getColumnManager(c);
+			if (section->managers[c] != NULL)
+			{
+				section->total += column.count;
+			}
+			else
+			{
+				log(m::LOG_WARNING) << "\"" << section->filename << "\": skipping a column of " << column.count << " components: no matching manager" << m::endl;
+			}
+		}
+
+		if (section->cancelled)
+		{
+			return false;
+		}
+
+		// Integration must never wait on the disk
+		snapshot.prefetch();
+		section->entities.resize(entityCount);
+		section->components.reserve(STREAM_BATCH_SIZE);
+		return true;
+	}
+
+	bool WorldStreamer::_integrateBatch(Section* section)
+	{
+		const WorldSnapshot& snapshot = section->snapshot;
+		const m::u32 entityCount = snapshot.getEntityCount();
+		const m::u32 batchSize = STREAM_BATCH_SIZE;
+		switch (section->step)
+		{
+			case STEP_ENTITIES:
+			{
+				const m::u32 count = std::min(batchSize, entityCount - section->cursor);
+				EntityManager::getInstance().create(section->entities.data() + section->cursor, count);
+				section->cursor += count;
+				section->done += count;
+				if (section->cursor == entityCount)
+				{
+					section->step = STEP_HIERARCHY;
+					section->cursor = 0;
+				}
+				return false;
+			}
+			case STEP_HIERARCHY:
+			{
+				// Parents always come first in a snapshot, they already exist
+				const m::u32* parents = snapshot.getParents();
+				const m::u32 end = section->cursor + std::min(batchSize, entityCount - section->cursor);
+				for (m::u32 i = section->cursor; i < end; ++i)
+				{
+					if (parents[i] != WorldSnapshot::SNAPSHOT_NO_PARENT && parents[i] < i)
+					{
+						section->entities[i]->setParent(section->entities[parents[i]]);
+					}
+				}
+				section->done += end - section->cursor;
+				section->cursor = end;
+				if (section->cursor == entityCount)
+				{
+					section->step = STEP_COMPONENTS;
+					section->cursor = 0;
+				}
+				return false;
+			}
+			case STEP_COMPONENTS:
+			{
+				while (section->column < snapshot.getColumnCount()
+					   && (section->managers[section->column] == NULL || snapshot.getColumn(section->column).count == 0))
+				{
+					++section->column;
+				}
+				if (section->column == snapshot.getColumnCount())
+				{
+					return true;
+				}
+
+				const SnapshotColumn& column = snapshot.getColumn(section->column);
+				manager::IBaseManager* manager = section->managers[section->column];
+				const m::u32 count = std::min(batchSize, column.count - section->cursor);
+				const m::u8* data = (const m::u8*)snapshot.getColumnData(section->column) + (m::u64)section->cursor * column.elementSize;
+				const m::u32* owners = snapshot.getColumnOwners(section->column) + section->cursor;
+
+				// One bulk copy in the storage, owners included, and one notification per batch
+				section->targets.resize(count);
+				section->owners.resize(count);
+				section->components.resize(count);
+				for (m::u32 i = 0; i < count; ++i)
+				{
+					section->targets[i] = section->entities[owners[i]];
+					section->owners[i] = section->targets[i]->getId();
+				}
+				manager->loadComponents(data, (m::i32)count, section->owners.data(), section->components.data());
+				for (m::u32 i = 0; i < count; ++i)
+				{
+					section->targets[i]->_bindComponent(section->components[i]);
+				}
+				manager->onComponentsAdded(section->targets.data(), section->components.data(), count);
+				section->done += count;
+				section->cursor += count;
+				if (section->cursor == column.count)
+				{
+					++section->column;
+					section->cursor = 0;
+				}
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void WorldStreamer::_rollback(Section* section)
+	{
+		// Only the first entities have been created so far
+		const m::u32 created = (section->step == STEP_ENTITIES ? section->cursor : section->snapshot.getEntityCount());
+		EntityManager& entities = EntityManager::getInstance();
+		for (m::u32 i = created; i > 0; --i)
+		{
+			entities.destroy(section->entities[i - 1]);
+		}
+		section->entities.clear();
+		section->snapshot.close();
+	}
+}
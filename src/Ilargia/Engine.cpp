@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <thread>
 
 // ***  MUON    ***
 #include <Muon/String.hpp>
@@ -34,7 +35,10 @@
 
 // ***  CORE    ***
 #include "Ilargia/Engine.hpp"
+#include "Ilargia/Component/CommandBuffer.hpp"
+#include "Ilargia/Component/WorldStreamer.hpp"
 #include "SharedLibrary.hpp"
+#include "Manager/ManagerScheduler.hpp"
 
 // ***  TYPE    ***
 #include "Ilargia/Type/Vector.hpp"
@@ -44,6 +48,7 @@
 #include "Ilargia/Type/Quaternion.hpp"
 
 // ***  SYSTEM  ***
+#include "Ilargia/System/JobSystem.hpp"
 #include "Ilargia/System/ScriptDriver.hpp"
 
 namespace ilg
@@ -67,6 +72,9 @@ namespace ilg
 
 	Engine::Engine()
 		: m_log("ENGINE")
+		, m_scheduler(NULL)
+		, m_jobWorkers(-1)
+		, m_logMemoryStats(false)
 		, m_running(false)
 		, m_paused(false)
 		, m_deltaTime(0.f)
@@ -115,6 +123,17 @@ namespace ilg
 			return false;
 		}
 
+		//Start worker threads, keeping one core for the main thread by default
+		m::i32 workers = engine.m_jobWorkers;
+		if (workers < 0)
+		{
+			workers = (m::i32)std::thread::hardware_concurrency() - 1;
+		}
+		system::JobSystem::getInstance().init(workers > 0 ? workers : 0);
+		CommandQueue::getInstance().init(system::JobSystem::getInstance().getWorkerCount() + 1);
+		WorldStreamer::getInstance().init();
+		engine.m_scheduler = MUON_NEW(manager::ManagerScheduler);
+
 		//Default KeyValue Variables
 		m::String app = "##No_Application_Name##";
 		m::String ver = "##No_Version##";
@@ -128,6 +147,13 @@ namespace ilg
 
 	void Engine::close()
 	{
+		//Stop worker threads
+		Engine& engine = getInstance();
+		WorldStreamer::getInstance().term();
+		system::JobSystem::getInstance().term();
+		MUON_DELETE(engine.m_scheduler);
+		engine.m_scheduler = NULL;
+
 		//Unload libraries
 		SharedLibrary::getInstance().unloadLibraries();
 
@@ -168,10 +194,20 @@ namespace ilg
 			return;
 		}
 
-		//Modules update
-		for (auto it = managerList.begin(); it != managerList.end(); ++it)
+		//Modules update, in parallel when their declared accesses allow it
+		m_scheduler->build(managerList);
+		m_scheduler->update(m_deltaTime);
+
+		//Sync point: apply structural changes recorded during the update
+		CommandQueue::getInstance().flush();
+		//Merge streamed sections, within the "Streaming" / "BudgetMs" time slice
+		WorldStreamer::getInstance().integrate();
+		EntityManager::getInstance().flushEvents();
+
+		_checkMemoryBudgets();
+		if (m_logMemoryStats)
 		{
-			(*it).manager->onUpdate(m_deltaTime);
+			logMemoryStats();
 		}
 
 		// Retrieve time information
@@ -241,6 +277,49 @@ namespace ilg
 		}
 	}
 
+	void Engine::_checkMemoryBudgets()
+	{
+		auto& managerList = SharedLibrary::getInstance().getManagers();
+		for (auto it = managerList.begin(); it != managerList.end(); ++it)
+		{
+			manager::IBaseManager* manager = it->manager;
+			if (manager->checkMemoryBudget())
+			{
+				const StorageStats stats = manager->getStats();
+				m_log(m::LOG_WARNING) << manager->getManagerName() << " is over its memory budget: "
+					<< (m::u32)(stats.bytes / 1024) << " KiB used, "
+					<< (m::u32)(manager->getMemoryBudget() / 1024) << " KiB allowed" << m::endl;
+			}
+		}
+	}
+
+	void Engine::logMemoryStats()
+	{
+		Engine& engine = getInstance();
+		auto& managerList = SharedLibrary::getInstance().getManagers();
+		engine.m_log(m::LOG_INFO) << "Manager\tSize\tCapacity\tPeak\tFree\tRealloc\tKiB\tUsed KiB\tFragmentation\tBudget KiB" << m::endl;
+		for (auto it = managerList.begin(); it != managerList.end(); ++it)
+		{
+			manager::IBaseManager* manager = it->manager;
+			if (manager->getComponentType() == MUON_TRAITS_ID(Component))
+			{
+				continue;
+			}
+			const StorageStats stats = manager->getStats();
+			engine.m_log(m::LOG_INFO) << manager->getManagerName()
+				<< "\t" << stats.size
+				<< "\t" << stats.capacity
+				<< "\t" << stats.peakSize
+				<< "\t" << stats.freeIndices
+				<< "\t" << stats.reallocCount
+				<< "\t" << (m::u32)(stats.bytes / 1024)
+				<< "\t" << (m::u32)(stats.usedBytes / 1024)
+				<< "\t" << stats.fragmentation
+				<< "\t" << (m::u32)(manager->getMemoryBudget() / 1024)
+				<< (manager->isOverBudget() ? " (OVER)" : "") << m::endl;
+		}
+	}
+
 	bool Engine::isRunning()
 	{
 		return getInstance().m_running;
@@ -34,6 +34,7 @@
 #include <Muon/String.hpp>
 #include <picojson.h>
 #include "Ilargia/Engine.hpp"
+#include "Ilargia/Component/WorldStreamer.hpp"
 #include "SharedLibrary.hpp"
 
 namespace ilg
@@ -78,6 +79,9 @@ namespace ilg
 			bool include = true;
 		};
 		std::map<m::String, ModuleIncExc> moduleIncludeExclude;
+		// Storage init variable: initial capacity and memory budget (in KiB) per Component type
+		std::map<m::String, m::i32> storageCapacity;
+		std::map<m::String, m::i32> storageBudget;
 
 		// Look for "Engine" object, which contains our value
 		auto& root = v.get<picojson::object>();
@@ -136,6 +140,57 @@ namespace ilg
 							}
 						}
 					}
+					// JOBS
+					// ***********
+					else if (itConfig->first == "Jobs")
+					{
+						auto& jobs = itConfig->second.get<picojson::object>();
+						auto it = jobs.find("Workers");
+						if (it != jobs.end() && it->second.is<double>())
+						{
+							m_jobWorkers = (m::i32)it->second.get<double>();
+						}
+					}
+					// STORAGE
+					// ***********
+					else if (itConfig->first == "Storage")
+					{
+						auto& storage = itConfig->second.get<picojson::object>();
+						auto readTypeValues = [&storage](const char* name, std::map<m::String, m::i32>& values)
+						{
+							auto it = storage.find(name);
+							if (it != storage.end() && it->second.is<picojson::object>())
+							{
+								auto& types = it->second.get<picojson::object>();
+								for (auto itType = types.begin(); itType != types.end(); ++itType)
+								{
+									if (itType->second.is<double>())
+									{
+										values[itType->first.c_str()] = (m::i32)itType->second.get<double>();
+									}
+								}
+							}
+						};
+						readTypeValues("Capacity", storageCapacity);
+						readTypeValues("BudgetKiB", storageBudget);
+
+						auto it = storage.find("LogStats");
+						if (it != storage.end() && it->second.is<bool>())
+						{
+							m_logMemoryStats = it->second.get<bool>();
+						}
+					}
+					// STREAMING
+					// ***********
+					else if (itConfig->first == "Streaming")
+					{
+						auto& streaming = itConfig->second.get<picojson::object>();
+						auto it = streaming.find("BudgetMs");
+						if (it != streaming.end() && it->second.is<double>())
+						{
+							WorldStreamer::getInstance().setTimeBudget((m::f32)it->second.get<double>());
+						}
+					}
 					// MODULES
 					// ***********
 					else if (itConfig->first == "Modules")
@@ -195,6 +250,23 @@ namespace ilg
 #endif
 			}
 		}
+
+		// Every manager is registered: pre-size their storage, and set their budget
+		auto& factory = manager::ManagerFactory::getInstance();
+		for (m::u32 i = 0; i < factory.getComponentTypeCount(); ++i)
+		{
+			const manager::ComponentTypeInfo& info = factory.getComponentTypeInfo(i);
+			auto it = storageCapacity.find(info.name);
+			if (it != storageCapacity.end() && it->second > 0)
+			{
+				info.manager->reserveComponents(it->second);
+			}
+			it = storageBudget.find(info.name);
+			if (it != storageBudget.end() && it->second > 0)
+			{
+				info.manager->setMemoryBudget((m::u64)it->second * 1024);
+			}
+		}
 		return true;
 	}
 }
@@ -34,9 +34,16 @@ namespace ilg
 	namespace manager
 	{
 		IBaseManager::IBaseManager(const m::String& name, m::u64 componentType, m::i32 updateOrder)
-			: m_log(name)
+			: m_componentStorage(NULL)
+			, m_log(name)
+			, m_typeName(name)
 			, m_componentType(componentType)
+			, m_typeIndex(INVALID_TYPE_INDEX)
 			, m_updateOrder(updateOrder)
+			, m_declaredAccess(false)
+			, m_eventSubscriptions(ENTITY_EVENT_NONE)
+			, m_memoryBudget(0)
+			, m_checkedReallocCount(0)
 		{
 			m_managerName = (componentType != MUON_TRAITS_ID(Component) ? "ComponentManager::" : "SimpleManager::");
 			m_managerName += name;
@@ -46,6 +53,21 @@ namespace ilg
 		{
 		}
 
+		void IBaseManager::onComponentsAdded(Entity* const* entities, Component* components, m::u32 count)
+		{
+			for (m::u32 i = 0; i < count; ++i)
+			{
+				onComponentAdded(entities[i], components[i]);
+			}
+		}
+
+		Component IBaseManager::createOwnedComponent(EntityId owner)
+		{
+			Component c = createComponent();
+			setComponentOwner(c, owner);
+			return c;
+		}
+
 		const m::String& IBaseManager::getManagerName() const
 		{
 			return m_managerName;
@@ -56,11 +78,80 @@ namespace ilg
 			return m_componentType;
 		}
 
+		m::u32 IBaseManager::getComponentTypeIndex() const
+		{
+			return m_typeIndex;
+		}
+
 		m::i32 IBaseManager::getUpdateOrder() const
 		{
 			return m_updateOrder;
 		}
 
+		const std::vector<m::u64>& IBaseManager::getReadAccess() const
+		{
+			return m_readAccess;
+		}
+
+		const std::vector<m::u64>& IBaseManager::getWriteAccess() const
+		{
+			return m_writeAccess;
+		}
+
+		bool IBaseManager::hasDeclaredAccess() const
+		{
+			return m_declaredAccess;
+		}
+
+		m::u32 IBaseManager::getEventSubscriptions() const
+		{
+			return m_eventSubscriptions;
+		}
+
+		void IBaseManager::setMemoryBudget(m::u64 bytes)
+		{
+			m_memoryBudget = bytes;
+		}
+
+		m::u64 IBaseManager::getMemoryBudget() const
+		{
+			return m_memoryBudget;
+		}
+
+		bool IBaseManager::isOverBudget() const
+		{
+			return m_memoryBudget > 0 && getStats().bytes > m_memoryBudget;
+		}
+
+		bool IBaseManager::checkMemoryBudget()
+		{
+			// Memory only changes when the storage is resized
+			const StorageStats stats = getStats();
+			if (stats.reallocCount == m_checkedReallocCount)
+			{
+				return false;
+			}
+			m_checkedReallocCount = stats.reallocCount;
+			return m_memoryBudget > 0 && stats.bytes > m_memoryBudget;
+		}
+
+		void IBaseManager::declareRead(m::u64 componentType)
+		{
+			m_declaredAccess = true;
+			m_readAccess.push_back(componentType);
+		}
+
+		void IBaseManager::declareWrite(m::u64 componentType)
+		{
+			m_declaredAccess = true;
+			m_writeAccess.push_back(componentType);
+		}
+
+		void IBaseManager::subscribe(m::u32 events)
+		{
+			m_eventSubscriptions |= events;
+		}
+
 		void IBaseManager::onKeyCallback(void* windowHandle, int key, int scancode, int action, int modifier)
 		{
 		}
@@ -74,7 +74,52 @@ namespace ilg
 			return Component();
 		}
 
-		void ISimpleManager::onEntityHierarchyChanged(Entity* entity, Entity* previousParent, Entity* newParent)
+		bool ISimpleManager::isComponentAlive(const Component& component) const
+		{
+			return false;
+		}
+
+		void ISimpleManager::setComponentOwner(const Component& component, EntityId owner)
+		{
+		}
+
+		void ISimpleManager::reserveComponents(m::i32 count)
+		{
+		}
+
+		void ISimpleManager::shrinkComponents()
+		{
+		}
+
+		StorageStats ISimpleManager::getStats() const
+		{
+			StorageStats stats = {};
+			return stats;
+		}
+
+		m::u32 ISimpleManager::getComponentSize() const
+		{
+			return 0;
+		}
+
+		bool ISimpleManager::isComponentSerializable() const
+		{
+			return false;
+		}
+
+		void ISimpleManager::copyComponents(void* dst, EntityId* owners) const
+		{
+		}
+
+		void ISimpleManager::loadComponents(const void* src, m::i32 count, const EntityId* owners, Component* out)
+		{
+		}
+
+		void ISimpleManager::cloneComponents(const void* src, m::i32 count, m::i32 copies, const EntityId* owners, Component* out)
+		{
+		}
+
+		void ISimpleManager::onEntityHierarchyChanged(const HierarchyEvent* events, m::u32 count)
 		{
 		}
 	}
@@ -35,12 +35,25 @@ namespace ilg
 {
 	namespace manager
 	{
+		m::u32 findComponentTypeIndex(m::u64 componentType)
+		{
+			return ManagerFactory::getInstance().getComponentTypeIndex(componentType);
+		}
+
 		ManagerFactory::ManagerFactory()
 		{
+			typedef std::unordered_map<m::u64, m::u32> TypeIndexMap;
+			typedef std::unordered_map<std::string, IBaseManager*> ManagerNameMap;
+			m_types = MUON_NEW(std::vector<ComponentTypeInfo>);
+			m_typeIndices = MUON_NEW(TypeIndexMap);
+			m_managerNames = MUON_NEW(ManagerNameMap);
 		}
 
 		ManagerFactory::~ManagerFactory()
 		{
+			MUON_DELETE(m_managerNames);
+			MUON_DELETE(m_typeIndices);
+			MUON_DELETE(m_types);
 		}
 
 		bool ManagerFactory::registerComponentManager(IBaseManager* manager)
@@ -48,6 +61,24 @@ namespace ilg
 			MUON_ASSERT_BREAK(manager != NULL, "Can't register a non allocated manager!");
 			if (checkComponentManager(manager->getManagerName()))
 			{
+				(*m_managerNames)[manager->getManagerName().cStr()] = manager;
+
+				//SimpleManager don't own a component type
+				m::u64 type = manager->getComponentType();
+				if (type != MUON_TRAITS_ID(Component) && m_typeIndices->find(type) == m_typeIndices->end())
+				{
+					MUON_ASSERT_BREAK(m_types->size() < ILARGIA_MAX_COMPONENT_TYPES
+									  , "Too many component types! (Max: %d, see ILARGIA_MAX_COMPONENT_TYPES)"
+									  , ILARGIA_MAX_COMPONENT_TYPES);
+					ComponentTypeInfo info;
+					info.id = type;
+					info.name = manager->m_typeName;
+					info.manager = manager;
+					manager->m_typeIndex = (m::u32)m_types->size();
+					(*m_typeIndices)[type] = manager->m_typeIndex;
+					m_types->push_back(info);
+				}
+
 				SharedLibrary::getInstance()._addModuleRef(manager);
 				return true;
 			}
@@ -57,46 +88,37 @@ namespace ilg
 		bool ManagerFactory::checkComponentManager(const m::String& name)
 		{
 			//Check if manager isn't already loaded
-			bool found = false;
-			auto& managerList = SharedLibrary::getInstance().m_managers;
-			for (auto it = managerList.begin(); it != managerList.end(); ++it)
-			{
-				if ((*it).manager->m_managerName == name)
-				{
-					found = true;
-					break;
-				}
-			}
+			bool found = (m_managerNames->find(name.cStr()) != m_managerNames->end());
 			MUON_ASSERT(found == false, "Module \"%s\" alread added: aborting...\n", name.cStr());
 			return !found;
 		}
 
 		IBaseManager* ManagerFactory::getComponentManager(m::u64 type)
 		{
-			auto& managerList = SharedLibrary::getInstance().m_managers;
-			for (auto it = managerList.begin(); it != managerList.end(); ++it)
-			{
-				if ((*it).manager->getComponentType() == type)
-				{
-					return (*it).manager;
-					break;
-				}
-			}
-			return NULL;
+			return getComponentManagerFromTypeIndex(getComponentTypeIndex(type));
 		}
 
 		IBaseManager* ManagerFactory::getComponentManager(const m::String& name)
 		{
-			auto& managerList = SharedLibrary::getInstance().m_managers;
-			for (auto it = managerList.begin(); it != managerList.end(); ++it)
-			{
-				if ((*it).manager->m_managerName == name)
-				{
-					return (*it).manager;
-					break;
-				}
-			}
-			return NULL;
+			auto it = m_managerNames->find(name.cStr());
+			return (it != m_managerNames->end() ? it->second : NULL);
+		}
+
+		m::u32 ManagerFactory::getComponentTypeIndex(m::u64 componentType) const
+		{
+			auto it = m_typeIndices->find(componentType);
+			return (it != m_typeIndices->end() ? it->second : INVALID_TYPE_INDEX);
+		}
+
+		m::u32 ManagerFactory::getComponentTypeCount() const
+		{
+			return m_types->size();
+		}
+
+		const ComponentTypeInfo& ManagerFactory::getComponentTypeInfo(m::u32 typeIndex) const
+		{
+			MUON_ASSERT_BREAK(typeIndex < m_types->size(), "No component type at index %d!", typeIndex);
+			return (*m_types)[typeIndex];
 		}
 
 		m::u32 ManagerFactory::getComponentManagerCount() const
@@ -0,0 +1,193 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#include <thread>
+#include <Muon/Memory/Allocator.hpp>
+#include "Ilargia/Manager/IBaseManager.hpp"
+#include "Ilargia/System/JobSystem.hpp"
+#include "ManagerScheduler.hpp"
+
+namespace ilg
+{
+	namespace manager
+	{
+		ManagerScheduler::ManagerScheduler()
+			: m_pending(NULL)
+			, m_remaining(0)
+			, m_deltaTime(0.f)
+		{
+		}
+
+		ManagerScheduler::~ManagerScheduler()
+		{
+			MUON_DELETE(m_pending);
+		}
+
+		void ManagerScheduler::build(const std::vector<CManagerPair>& managers)
+		{
+			m_nodes.resize(managers.size());
+			for (m::u32 i = 0; i < managers.size(); ++i)
+			{
+				Node& node = m_nodes[i];
+				node.manager = managers[i].manager;
+				node.mainThread = !node.manager->hasDeclaredAccess();
+				node.dependencyCount = 0;
+				node.successors.clear();
+				for (m::u32 j = 0; j < i; ++j)
+				{
+					if (_conflict(m_nodes[j].manager, node.manager))
+					{
+						m_nodes[j].successors.push_back(i);
+						++node.dependencyCount;
+					}
+				}
+			}
+
+			// Atomics can't be moved: the list is allocated again rather than resized
+			if (m_pending == NULL || m_pending->size() < m_nodes.size())
+			{
+				MUON_DELETE(m_pending);
+				m_pending = MUON_NEW(PendingList, m_nodes.size());
+			}
+		}
+
+		void ManagerScheduler::update(m::f32 deltaTime)
+		{
+			m_deltaTime = deltaTime;
+			m_remaining = (m::i32)m_nodes.size();
+			for (m::u32 i = 0; i < m_nodes.size(); ++i)
+			{
+				(*m_pending)[i] = m_nodes[i].dependencyCount;
+			}
+			for (m::u32 i = 0; i < m_nodes.size(); ++i)
+			{
+				if (m_nodes[i].dependencyCount == 0)
+				{
+					_schedule(i);
+				}
+			}
+
+			// Main thread executes main-thread managers, and helps the workers otherwise
+			auto& jobs = system::JobSystem::getInstance();
+			while (m_remaining.load() > 0)
+			{
+				bool hasMainNode = false;
+				m::u32 node = 0;
+				{
+					std::lock_guard<std::mutex> lock(m_mainMutex);
+					if (!m_mainReady.empty())
+					{
+						node = m_mainReady.front();
+						m_mainReady.pop_front();
+						hasMainNode = true;
+					}
+				}
+
+				if (hasMainNode)
+				{
+					_execute(node);
+				}
+				else if (!jobs.runPendingJob())
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		bool ManagerScheduler::_conflict(const IBaseManager* l, const IBaseManager* r) const
+		{
+			if (!l->hasDeclaredAccess() || !r->hasDeclaredAccess())
+			{
+				return true;
+			}
+
+			// Write/Write or Read/Write on the same Component type
+			const std::vector<m::u64>& lw = l->getWriteAccess();
+			const std::vector<m::u64>& rw = r->getWriteAccess();
+			const std::vector<m::u64>& lr = l->getReadAccess();
+			const std::vector<m::u64>& rr = r->getReadAccess();
+			for (auto w = lw.begin(); w != lw.end(); ++w)
+			{
+				for (auto it = rw.begin(); it != rw.end(); ++it)
+				{
+					if (*w == *it)
+					{
+						return true;
+					}
+				}
+				for (auto it = rr.begin(); it != rr.end(); ++it)
+				{
+					if (*w == *it)
+					{
+						return true;
+					}
+				}
+			}
+			for (auto w = rw.begin(); w != rw.end(); ++w)
+			{
+				for (auto it = lr.begin(); it != lr.end(); ++it)
+				{
+					if (*w == *it)
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		void ManagerScheduler::_schedule(m::u32 node)
+		{
+			if (m_nodes[node].mainThread)
+			{
+				std::lock_guard<std::mutex> lock(m_mainMutex);
+				m_mainReady.push_back(node);
+			}
+			else
+			{
+				system::JobSystem::getInstance().submit([this, node]()
+				{
+					_execute(node);
+				});
+			}
+		}
+
+		void ManagerScheduler::_execute(m::u32 node)
+		{
+			Node& n = m_nodes[node];
+			n.manager->onUpdate(m_deltaTime);
+			for (auto it = n.successors.begin(); it != n.successors.end(); ++it)
+			{
+				if (--(*m_pending)[*it] == 0)
+				{
+					_schedule(*it);
+				}
+			}
+			--m_remaining;
+		}
+	}
+}
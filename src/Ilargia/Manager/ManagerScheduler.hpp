@@ -0,0 +1,87 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#ifndef INCLUDE_ILARGIA_MANAGERSCHEDULER_HPP
+#define INCLUDE_ILARGIA_MANAGERSCHEDULER_HPP
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "Ilargia/Core/Define.hpp"
+#include "../SharedLibrary.hpp"
+
+namespace ilg
+{
+	namespace manager
+	{
+		/*!
+		* @brief Update managers in parallel when their accesses allow it
+		* Each frame, a dependency graph is built from the manager list (sorted
+		* by update order): a manager depends on every previous one it
+		* conflicts with, see IBaseManager::getReadAccess().
+		* Managers are then updated as soon as their dependencies are done,
+		* on the JobSystem workers, or on the main thread for the ones without
+		* declared access.
+		*/
+		class ManagerScheduler
+		{
+		public:
+			ManagerScheduler();
+			~ManagerScheduler();
+
+			//! Build the dependency graph of the managers
+			void build(const std::vector<CManagerPair>& managers);
+
+			//! Call onUpdate() on every manager, return once they are all done
+			void update(m::f32 deltaTime);
+
+		private:
+			struct Node
+			{
+				IBaseManager* manager;
+				bool mainThread;
+				m::u32 dependencyCount;
+				std::vector<m::u32> successors;
+			};
+
+			bool _conflict(const IBaseManager* l, const IBaseManager* r) const;
+			void _schedule(m::u32 node);
+			void _execute(m::u32 node);
+
+			std::vector<Node> m_nodes;
+			typedef std::vector<std::atomic<m::i32> > PendingList;
+			PendingList* m_pending;
+			std::atomic<m::i32> m_remaining;
+			std::mutex m_mainMutex;
+			std::deque<m::u32> m_mainReady;
+			m::f32 m_deltaTime;
+		};
+	}
+}
+
+#endif
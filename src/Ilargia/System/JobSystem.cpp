@@ -0,0 +1,226 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#include <chrono>
+#include <Muon/System/Assert.hpp>
+#include <Muon/Memory/Allocator.hpp>
+#include "Ilargia/System/JobSystem.hpp"
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#	define ILARGIA_THREAD_LOCAL __declspec(thread)
+#else
+#	define ILARGIA_THREAD_LOCAL thread_local
+#endif
+
+namespace
+{
+	// Threads not owned by the JobSystem keep the invalid index
+	static const m::u32 INVALID_THREAD_INDEX = 0xFFFFFFFF;
+	static ILARGIA_THREAD_LOCAL m::u32 currentThreadIndex = INVALID_THREAD_INDEX;
+}
+
+namespace ilg
+{
+	namespace system
+	{
+		JobSystem::JobSystem()
+			: m_workers(NULL)
+			, m_queues(NULL)
+			, m_queueCount(0)
+			, m_running(false)
+			, m_pendingJobs(0)
+		{
+			// Usable before init(): everything runs on the main thread
+			currentThreadIndex = 0;
+			m_queueCount = 1;
+			m_queues = MUON_NEW(WorkQueueList, 1);
+			m_workers = MUON_NEW(std::vector<std::thread>);
+		}
+
+		JobSystem::~JobSystem()
+		{
+			term();
+			MUON_DELETE(m_queues);
+			MUON_DELETE(m_workers);
+		}
+
+		void JobSystem::init(m::u32 workerCount)
+		{
+			MUON_ASSERT(!m_running, "JobSystem is already initialized!");
+			MUON_ASSERT(currentThreadIndex == 0, "JobSystem must be initialized on the main thread!");
+			if (m_running)
+			{
+				return;
+			}
+
+			// Keep jobs that may have been queued on the main thread
+			std::deque<Job> mainJobs;
+			mainJobs.swap((*m_queues)[0].jobs);
+			MUON_DELETE(m_queues);
+
+			m_queueCount = workerCount + 1;
+			m_queues = MUON_NEW(WorkQueueList, m_queueCount);
+			(*m_queues)[0].jobs.swap(mainJobs);
+
+			m_running = true;
+			for (m::u32 i = 1; i < m_queueCount; ++i)
+			{
+				m_workers->push_back(std::thread(&JobSystem::_workerLoop, this, i));
+			}
+		}
+
+		void JobSystem::term()
+		{
+			while (runPendingJob())
+			{
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+				m_running = false;
+			}
+			m_sleepCondition.notify_all();
+			for (auto it = m_workers->begin(); it != m_workers->end(); ++it)
+			{
+				it->join();
+			}
+			m_workers->clear();
+		}
+
+		m::u32 JobSystem::getWorkerCount() const
+		{
+			return m_queueCount - 1;
+		}
+
+		m::u32 JobSystem::getThreadIndex()
+		{
+			MUON_ASSERT_BREAK(currentThreadIndex != INVALID_THREAD_INDEX
+							  , "Thread is not owned by the JobSystem, it has no per-thread state!");
+			return currentThreadIndex;
+		}
+
+		void JobSystem::submit(const JobFunc& job, JobCounter* counter)
+		{
+			if (counter != NULL)
+			{
+				++(*counter);
+			}
+			Job j = { job, counter };
+			{
+				WorkQueue& queue = (*m_queues)[getThreadIndex()];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				queue.jobs.push_back(j);
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+				++m_pendingJobs;
+			}
+			m_sleepCondition.notify_one();
+		}
+
+		void JobSystem::wait(JobCounter* counter)
+		{
+			while (counter->load() > 0)
+			{
+				if (!runPendingJob())
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		bool JobSystem::runPendingJob()
+		{
+			Job job;
+			m::u32 thread = getThreadIndex();
+			if (_pop(thread, job) || _steal(thread, job))
+			{
+				_execute(job);
+				return true;
+			}
+			return false;
+		}
+
+		bool JobSystem::_pop(m::u32 thread, Job& job)
+		{
+			// Newest job first: its data is most likely still in cache
+			WorkQueue& queue = (*m_queues)[thread];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.jobs.empty())
+			{
+				return false;
+			}
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			return true;
+		}
+
+		bool JobSystem::_steal(m::u32 thief, Job& job)
+		{
+			// Oldest job of another queue, starting with the next one so
+			// thieves don't all target the same queue
+			for (m::u32 i = 1; i < m_queueCount; ++i)
+			{
+				WorkQueue& queue = (*m_queues)[(thief + i) % m_queueCount];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				if (!queue.jobs.empty())
+				{
+					job = queue.jobs.front();
+					queue.jobs.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void JobSystem::_execute(Job& job)
+		{
+			--m_pendingJobs;
+			job.func();
+			if (job.counter != NULL)
+			{
+				--(*job.counter);
+			}
+		}
+
+		void JobSystem::_workerLoop(m::u32 index)
+		{
+			currentThreadIndex = index;
+			while (m_running)
+			{
+				if (!runPendingJob())
+				{
+					std::unique_lock<std::mutex> lock(m_sleepMutex);
+					m_sleepCondition.wait_for(lock, std::chrono::milliseconds(1), [this]()
+					{
+						return m_pendingJobs.load() > 0 || !m_running;
+					});
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,165 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+#include "Ilargia/System/MappedFile.hpp"
+
+#if defined(MUON_PLATFORM_WINDOWS)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace ilg
+{
+	namespace system
+	{
+		MappedFile::MappedFile()
+			: m_data(NULL)
+			, m_size(0)
+			, m_file(NULL)
+			, m_mapping(NULL)
+		{
+		}
+
+		MappedFile::~MappedFile()
+		{
+			close();
+		}
+
+		bool MappedFile::open(const m::String& filename)
+		{
+			close();
+#if defined(MUON_PLATFORM_WINDOWS)
+			HANDLE file = CreateFileA(filename.cStr(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			{
+				CloseHandle(file);
+				return false;
+			}
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping == NULL)
+			{
+				CloseHandle(file);
+				return false;
+			}
+			void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (data == NULL)
+			{
+				CloseHandle(mapping);
+				CloseHandle(file);
+				return false;
+			}
+			m_file = file;
+			m_mapping = mapping;
+			m_size = (m::u64)size.QuadPart;
+#else
+			int fd = ::open(filename.cStr(), O_RDONLY);
+			if (fd < 0)
+			{
+				return false;
+			}
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size == 0)
+			{
+				::close(fd);
+				return false;
+			}
+			void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			// The mapping stays valid once the descriptor is closed
+			::close(fd);
+			if (data == MAP_FAILED)
+			{
+				return false;
+			}
+			m_size = (m::u64)st.st_size;
+#endif
+			m_data = (const m::u8*)data;
+			return true;
+		}
+
+		void MappedFile::close()
+		{
+			if (m_data == NULL)
+			{
+				return;
+			}
+#if defined(MUON_PLATFORM_WINDOWS)
+			UnmapViewOfFile(m_data);
+			CloseHandle((HANDLE)m_mapping);
+			CloseHandle((HANDLE)m_file);
+#else
+			munmap((void*)m_data, (size_t)m_size);
+#endif
+			m_data = NULL;
+			m_size = 0;
+			m_file = NULL;
+			m_mapping = NULL;
+		}
+
+		bool MappedFile::isOpen() const
+		{
+			return m_data != NULL;
+		}
+
+		const m::u8* MappedFile::data() const
+		{
+			return m_data;
+		}
+
+		m::u64 MappedFile::size() const
+		{
+			return m_size;
+		}
+
+		void MappedFile::prefetch() const
+		{
+			if (m_data == NULL)
+			{
+				return;
+			}
+#if !defined(MUON_PLATFORM_WINDOWS)
+			madvise((void*)m_data, (size_t)m_size, MADV_WILLNEED);
+#endif
+			// Touch one byte per page, so each one is actually resident
+			const m::u64 pageSize = 4096;
+			volatile m::u8 sink = 0;
+			for (m::u64 offset = 0; offset < m_size; offset += pageSize)
+			{
+				sink += m_data[offset];
+			}
+			(void)sink;
+		}
+	}
+}
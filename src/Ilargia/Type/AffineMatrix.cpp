@@ -0,0 +1,151 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include <Muon/System/Assert.hpp>
+#include <Muon/System/Log.hpp>
+#include "Ilargia/Type/AffineMatrix.hpp"
+
+namespace ilg
+{
+	const AffineMatrix AffineMatrix::Identity =
+	{
+		{ 1, 0, 0, 0 },
+		{ 0, 1, 0, 0 },
+		{ 0, 0, 1, 0 }
+	};
+
+	AffineMatrix::AffineMatrix(MatrixRow _x, MatrixRow _y, MatrixRow _z)
+		: x(_x)
+		, y(_y)
+		, z(_z)
+	{
+	}
+
+	AffineMatrix::AffineMatrix(const Matrix& m)
+		: x(m.x.x, m.y.x, m.z.x, m.w.x)
+		, y(m.x.y, m.y.y, m.z.y, m.w.y)
+		, z(m.x.z, m.y.z, m.z.z, m.w.z)
+	{
+	}
+
+	Matrix AffineMatrix::toMatrix() const
+	{
+		return Matrix(MatrixRow(x.x, y.x, z.x, 0.f)
+					  , MatrixRow(x.y, y.y, z.y, 0.f)
+					  , MatrixRow(x.z, y.z, z.z, 0.f)
+					  , MatrixRow(x.w, y.w, z.w, 1.f));
+	}
+
+	MatrixRow AffineMatrix::operator[](m::i32 i) const
+	{
+		return *(&x + i);
+	}
+
+	MatrixRow& AffineMatrix::operator[](m::i32 i)
+	{
+		return *(&x + i);
+	}
+
+	m::f32 AffineMatrix::determinant() const
+	{
+		return x.x * (y.y * z.z - y.z * z.y)
+			- x.y * (y.x * z.z - y.z * z.x)
+			+ x.z * (y.x * z.y - y.y * z.x);
+	}
+
+	AffineMatrix AffineMatrix::inverse() const
+	{
+		//Adjugate of the linear part, divided by its determinant
+		const m::f32 det = determinant();
+		MUON_ASSERT_BREAK(det != 0.0f, "AffineMatrix is not invertible !");
+		const m::f32 k = (det != 0.0f ? 1.f / det : 0.f);
+
+		AffineMatrix inv;
+		inv.x.x = (y.y * z.z - y.z * z.y) * k;
+		inv.x.y = (x.z * z.y - x.y * z.z) * k;
+		inv.x.z = (x.y * y.z - x.z * y.y) * k;
+		inv.y.x = (y.z * z.x - y.x * z.z) * k;
+		inv.y.y = (x.x * z.z - x.z * z.x) * k;
+		inv.y.z = (x.z * y.x - x.x * y.z) * k;
+		inv.z.x = (y.x * z.y - y.y * z.x) * k;
+		inv.z.y = (x.y * z.x - x.x * z.y) * k;
+		inv.z.z = (x.x * y.y - x.y * y.x) * k;
+
+		//Undo the translation: -inverse(linear) * translation
+		inv.x.w = -(inv.x.x * x.w + inv.x.y * y.w + inv.x.z * z.w);
+		inv.y.w = -(inv.y.x * x.w + inv.y.y * y.w + inv.y.z * z.w);
+		inv.z.w = -(inv.z.x * x.w + inv.z.y * y.w + inv.z.z * z.w);
+		return inv;
+	}
+
+	Vector AffineMatrix::transformPoint(const Vector& p) const
+	{
+		return Vector(x.x * p.x + x.y * p.y + x.z * p.z + x.w
+					  , y.x * p.x + y.y * p.y + y.z * p.z + y.w
+					  , z.x * p.x + z.y * p.y + z.z * p.z + z.w);
+	}
+
+	Vector AffineMatrix::transformVector(const Vector& v) const
+	{
+		return Vector(x.x * v.x + x.y * v.y + x.z * v.z
+					  , y.x * v.x + y.y * v.y + y.z * v.z
+					  , z.x * v.x + z.y * v.y + z.z * v.z);
+	}
+
+	AffineMatrix AffineMatrix::operator*(const AffineMatrix& n) const
+	{
+		AffineMatrix mn;
+		for (m::i32 i = 0; i < 3; ++i)
+		{
+			const MatrixRow& r = (&x)[i];
+			MatrixRow& o = mn[i];
+			o.x = r.x * n.x.x + r.y * n.y.x + r.z * n.z.x;
+			o.y = r.x * n.x.y + r.y * n.y.y + r.z * n.z.y;
+			o.z = r.x * n.x.z + r.y * n.y.z + r.z * n.z.z;
+			o.w = r.x * n.x.w + r.y * n.y.w + r.z * n.z.w + r.w;
+		}
+		return mn;
+	}
+
+	bool AffineMatrix::operator==(const AffineMatrix& m) const
+	{
+		return (x == m.x
+				&& y == m.y
+				&& z == m.z);
+	}
+
+	bool AffineMatrix::operator!=(const AffineMatrix& m) const
+	{
+		return !operator==(m);
+	}
+}
+
+m::system::Log& operator<<(m::system::Log& stream, const ilg::AffineMatrix& m)
+{
+	return stream << "[" << m.x << ", " << m.y << ", " << m.z << "]";
+}
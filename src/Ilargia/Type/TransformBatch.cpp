@@ -0,0 +1,298 @@
+/*************************************************************************
+* Ilargia Engine - http://github.com/Xipiryon/Ilargia
+* C++ Modular Data Oriented Game Enginee
+*------------------------------------------------------------------------
+* Copyright (c) 2014-2015, Louis Schnellbach
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+*    claim that you wrote the original software. If you use this software
+*    in a product, an acknowledgment in the product documentation would
+*    be appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not
+*    be misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source
+*    distribution.
+*
+*************************************************************************/
+
+
+#include "Ilargia/Type/TransformBatch.hpp"
+
+#if defined(ILARGIA_SIMD_SSE)
+#	include <emmintrin.h>
+// Shared by the SSE and AVX2 kernels: a call from AVX2 code to a function
+// compiled for SSE would switch between the two encodings at each call
+#	if defined(_MSC_VER)
+#		define ILARGIA_FORCE_INLINE __forceinline
+#	else
+#		define ILARGIA_FORCE_INLINE inline __attribute__((always_inline))
+#	endif
+#endif
+#if defined(ILARGIA_SIMD_AVX2)
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#		define ILARGIA_TARGET_AVX2
+#	else
+#		define ILARGIA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#	endif
+#endif
+
+namespace
+{
+	static_assert(sizeof(ilg::AffineMatrix) == 12 * sizeof(m::f32), "AffineMatrix rows are loaded as 4 contiguous floats");
+
+	ilg::SimdLevel detectSimdLevel()
+	{
+#if defined(ILARGIA_SIMD_AVX2)
+#	if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] >= 7)
+		{
+			__cpuid(info, 1);
+			const bool fma = (info[2] & (1 << 12)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			__cpuidex(info, 7, 0);
+			const bool avx2 = (info[1] & (1 << 5)) != 0;
+			// The OS must also save the AVX registers
+			if (fma && avx2 && osxsave && (_xgetbv(0) & 6) == 6)
+			{
+				return ilg::SIMD_AVX2;
+			}
+		}
+#	else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return ilg::SIMD_AVX2;
+		}
+#	endif
+#endif
+#if defined(ILARGIA_SIMD_SSE)
+		return ilg::SIMD_SSE;
+#else
+		return ilg::SIMD_SCALAR;
+#endif
+	}
+
+	const ilg::SimdLevel s_supportedLevel = detectSimdLevel();
+	ilg::SimdLevel s_level = s_supportedLevel;
+
+	/*!
+	* Local AffineMatrix (l, 3 rows of 4 floats) multiplied by the parent one.
+	* Each output row is a sum of local rows, so it is computed 4 floats at a time.
+	*/
+	MUON_INLINE void multiplyParent(const m::f32* l, const ilg::AffineMatrix& p, ilg::AffineMatrix& out)
+	{
+		// Copied first: otherwise each output write could change the parent, as far as the compiler knows
+		const ilg::AffineMatrix parent = p;
+		// Implicit last row of the local matrix: same operations on the 4 columns
+		static const m::f32 w[4] = { 0.f, 0.f, 0.f, 1.f };
+		m::f32* o = &out.x.x;
+		for (m::i32 row = 0; row < 3; ++row)
+		{
+			const m::f32* r = &parent.x.x + row * 4;
+			for (m::i32 c = 0; c < 4; ++c)
+			{
+				o[row * 4 + c] = r[0] * l[c] + r[1] * l[4 + c] + r[2] * l[8 + c] + r[3] * w[c];
+			}
+		}
+	}
+
+	void composeScalar(const ilg::TransformBatch& b, m::u32 begin)
+	{
+		for (m::u32 i = begin; i < b.count; ++i)
+		{
+			const m::f32 xx = b.qx[i] * b.qx[i], xy = b.qx[i] * b.qy[i], xz = b.qx[i] * b.qz[i], xw = b.qx[i] * b.qw[i];
+			const m::f32 yy = b.qy[i] * b.qy[i], yz = b.qy[i] * b.qz[i], yw = b.qy[i] * b.qw[i];
+			const m::f32 zz = b.qz[i] * b.qz[i], zw = b.qz[i] * b.qw[i];
+			// Scaled rotation, transposed, and position
+			const m::f32 l[12] =
+			{
+				b.sx[i] * (1.f - 2.f * (yy + zz)), b.sy[i] * 2.f * (xy + zw), b.sz[i] * 2.f * (xz - yw), b.px[i],
+				b.sx[i] * 2.f * (xy - zw), b.sy[i] * (1.f - 2.f * (xx + zz)), b.sz[i] * 2.f * (yz + xw), b.py[i],
+				b.sx[i] * 2.f * (xz + yw), b.sy[i] * 2.f * (yz - xw), b.sz[i] * (1.f - 2.f * (xx + yy)), b.pz[i],
+			};
+			multiplyParent(l, *b.parents[i], *b.outputs[i]);
+		}
+	}
+
+#if defined(ILARGIA_SIMD_SSE)
+	//! Row of the parent (r) multiplied by the local rows, the last one being (0, 0, 0, 1)
+	ILARGIA_FORCE_INLINE __m128 multiplyRowSse(const m::f32* r, __m128 l0, __m128 l1, __m128 l2, __m128 wMask)
+	{
+		__m128 v = _mm_and_ps(_mm_loadu_ps(r), wMask);
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(r[0]), l0));
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(r[1]), l1));
+		return _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(r[2]), l2));
+	}
+
+	/*!
+	* Same as multiplyParent(), for the transforms starting at i. l0, l1 and l2
+	* hold the rows of the local AffineMatrix of each of them.
+	*/
+	ILARGIA_FORCE_INLINE void multiplyParentsSse(const __m128* l0, const __m128* l1, const __m128* l2, m::u32 count, ilg::TransformBatch& b, m::u32 i)
+	{
+		const __m128 wMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+		// In order: a parent may be an output of a previous lane
+		for (m::u32 lane = 0; lane < count; ++lane)
+		{
+			// A Transform is never its own parent: the output can be written row by row
+			const m::f32* p = &b.parents[i + lane]->x.x;
+			m::f32* out = &b.outputs[i + lane]->x.x;
+			_mm_storeu_ps(out, multiplyRowSse(p, l0[lane], l1[lane], l2[lane], wMask));
+			_mm_storeu_ps(out + 4, multiplyRowSse(p + 4, l0[lane], l1[lane], l2[lane], wMask));
+			_mm_storeu_ps(out + 8, multiplyRowSse(p + 8, l0[lane], l1[lane], l2[lane], wMask));
+		}
+	}
+
+	void composeSse(ilg::TransformBatch& b)
+	{
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 two = _mm_set1_ps(2.f);
+		__m128 rs[9];
+		m::u32 i = 0;
+		for (; i + 4 <= b.count; i += 4)
+		{
+			const __m128 qx = _mm_loadu_ps(b.qx + i), qy = _mm_loadu_ps(b.qy + i), qz = _mm_loadu_ps(b.qz + i), qw = _mm_loadu_ps(b.qw + i);
+			const __m128 sx = _mm_loadu_ps(b.sx + i), sy = _mm_loadu_ps(b.sy + i), sz = _mm_loadu_ps(b.sz + i);
+			const __m128 xx = _mm_mul_ps(qx, qx), xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), xw = _mm_mul_ps(qx, qw);
+			const __m128 yy = _mm_mul_ps(qy, qy), yz = _mm_mul_ps(qy, qz), yw = _mm_mul_ps(qy, qw);
+			const __m128 zz = _mm_mul_ps(qz, qz), zw = _mm_mul_ps(qz, qw);
+
+			rs[0] = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+			rs[1] = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xy, zw)));
+			rs[2] = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xz, yw)));
+			rs[3] = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(xy, zw)));
+			rs[4] = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+			rs[5] = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(yz, xw)));
+			rs[6] = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(xz, yw)));
+			rs[7] = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(yz, xw)));
+			rs[8] = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+
+			// rs holds the 9 row-major values of each transform, one lane per transform. Once
+			// transposed, a lane gives a row (3 values and the position) of its AffineMatrix.
+			__m128 l0[4] = { rs[0], rs[3], rs[6], _mm_loadu_ps(b.px + i) };
+			__m128 l1[4] = { rs[1], rs[4], rs[7], _mm_loadu_ps(b.py + i) };
+			__m128 l2[4] = { rs[2], rs[5], rs[8], _mm_loadu_ps(b.pz + i) };
+			_MM_TRANSPOSE4_PS(l0[0], l0[1], l0[2], l0[3]);
+			_MM_TRANSPOSE4_PS(l1[0], l1[1], l1[2], l1[3]);
+			_MM_TRANSPOSE4_PS(l2[0], l2[1], l2[2], l2[3]);
+			multiplyParentsSse(l0, l1, l2, 4, b, i);
+		}
+		composeScalar(b, i);
+	}
+#endif
+
+#if defined(ILARGIA_SIMD_AVX2)
+	//! Lane j of (a, b, c, d), as 4 contiguous floats, in out[j]
+	ILARGIA_TARGET_AVX2 ILARGIA_FORCE_INLINE void transposeAvx2(__m256 a, __m256 b, __m256 c, __m256 d, __m128* out)
+	{
+		const __m256 ab0 = _mm256_unpacklo_ps(a, b), ab1 = _mm256_unpackhi_ps(a, b);
+		const __m256 cd0 = _mm256_unpacklo_ps(c, d), cd1 = _mm256_unpackhi_ps(c, d);
+		const __m256 rows[4] =
+		{
+			_mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(3, 2, 3, 2)),
+			_mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(3, 2, 3, 2)),
+		};
+		for (m::u32 j = 0; j < 4; ++j)
+		{
+			out[j] = _mm256_castps256_ps128(rows[j]);
+			out[j + 4] = _mm256_extractf128_ps(rows[j], 1);
+		}
+	}
+
+	ILARGIA_TARGET_AVX2 void composeAvx2(ilg::TransformBatch& b)
+	{
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 two = _mm256_set1_ps(2.f);
+		__m256 rs[9];
+		m::u32 i = 0;
+		for (; i + 8 <= b.count; i += 8)
+		{
+			const __m256 qx = _mm256_loadu_ps(b.qx + i), qy = _mm256_loadu_ps(b.qy + i), qz = _mm256_loadu_ps(b.qz + i), qw = _mm256_loadu_ps(b.qw + i);
+			const __m256 sx = _mm256_loadu_ps(b.sx + i), sy = _mm256_loadu_ps(b.sy + i), sz = _mm256_loadu_ps(b.sz + i);
+			const __m256 xx = _mm256_mul_ps(qx, qx), xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), xw = _mm256_mul_ps(qx, qw);
+			const __m256 yy = _mm256_mul_ps(qy, qy), yz = _mm256_mul_ps(qy, qz), yw = _mm256_mul_ps(qy, qw);
+			const __m256 zz = _mm256_mul_ps(qz, qz), zw = _mm256_mul_ps(qz, qw);
+
+			// 1 - 2 * (a + b) as a single fnmadd
+			rs[0] = _mm256_mul_ps(sx, _mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one));
+			rs[1] = _mm256_mul_ps(sx, _mm256_mul_ps(two, _mm256_sub_ps(xy, zw)));
+			rs[2] = _mm256_mul_ps(sx, _mm256_mul_ps(two, _mm256_add_ps(xz, yw)));
+			rs[3] = _mm256_mul_ps(sy, _mm256_mul_ps(two, _mm256_add_ps(xy, zw)));
+			rs[4] = _mm256_mul_ps(sy, _mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one));
+			rs[5] = _mm256_mul_ps(sy, _mm256_mul_ps(two, _mm256_sub_ps(yz, xw)));
+			rs[6] = _mm256_mul_ps(sz, _mm256_mul_ps(two, _mm256_sub_ps(xz, yw)));
+			rs[7] = _mm256_mul_ps(sz, _mm256_mul_ps(two, _mm256_add_ps(yz, xw)));
+			rs[8] = _mm256_mul_ps(sz, _mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one));
+
+			// Same transpose as composeSse(), on both halves at once: lanes 0-3 end up
+			// in the low halves, lanes 4-7 in the high ones
+			__m128 l0[8], l1[8], l2[8];
+			transposeAvx2(rs[0], rs[3], rs[6], _mm256_loadu_ps(b.px + i), l0);
+			transposeAvx2(rs[1], rs[4], rs[7], _mm256_loadu_ps(b.py + i), l1);
+			transposeAvx2(rs[2], rs[5], rs[8], _mm256_loadu_ps(b.pz + i), l2);
+			multiplyParentsSse(l0, l1, l2, 8, b, i);
+		}
+		composeScalar(b, i);
+	}
+#endif
+}
+
+namespace ilg
+{
+	SimdLevel getSupportedSimdLevel()
+	{
+		return s_supportedLevel;
+	}
+
+	SimdLevel getSimdLevel()
+	{
+		return s_level;
+	}
+
+	void setSimdLevel(SimdLevel level)
+	{
+		s_level = (level < s_supportedLevel ? level : s_supportedLevel);
+	}
+
+	TransformBatch::TransformBatch()
+		: count(0)
+	{
+	}
+
+	void composeTransforms(TransformBatch& batch)
+	{
+		switch (s_level)
+		{
+#if defined(ILARGIA_SIMD_AVX2)
+			case SIMD_AVX2:
+				composeAvx2(batch);
+				break;
+#endif
+#if defined(ILARGIA_SIMD_SSE)
+			case SIMD_SSE:
+				composeSse(batch);
+				break;
+#endif
+			default:
+				composeScalar(batch, 0);
+				break;
+		}
+		batch.count = 0;
+	}
+}